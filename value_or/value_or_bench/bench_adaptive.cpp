@@ -0,0 +1,138 @@
+/**********************************************************************
+ * \file   bench_adaptive.cpp
+ * \brief  Benchmark of value_or_adaptive against value_or_batch, that
+ *         always uses the vectorized selects, on three columns of int
+ *         with different patterns of nulls. It prints the time of
+ *         both and the kernels chosen by value_or_adaptive: where it
+ *         chooses blend on random nulls it should cost as
+ *         value_or_batch plus the sample, elsewhere it should be
+ *         faster. In complementary the second column has values
+ *         exactly where the first one is null, so blend skips the
+ *         third column.
+ *         The two versions run alternately and the best of 15 runs
+ *         is kept, to reduce the noise of the other processes.
+ *
+ *         build: g++ -std=c++20 -O2 bench_adaptive.cpp
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "../value_or_ex/value_or_adaptive.h"
+
+
+struct column
+{
+    std::vector<int> values;
+    std::vector<std::uint8_t> valid;
+
+    // the row i is null with probability null_probability(i)
+    column(std::size_t rows, const std::function<double(std::size_t)>& null_probability, unsigned seed)
+        : values(rows), valid(rows)
+    {
+        std::mt19937 gen{ seed };
+        std::uniform_real_distribution<double> dist{ 0, 1 };
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            values[i] = static_cast<int>(i & 0xFF);
+            valid[i] = dist(gen) >= null_probability(i);
+        }
+    }
+
+    s4::nullable_column<int> view() const
+    {
+        return { values, valid };
+    }
+};
+
+/**
+ * It returns the best times, in nanoseconds per row, of f and g, run
+ * alternately.
+ */
+template<typename F, typename G>
+std::array<double, 2> time_per_row(std::size_t rows, F f, G g)
+{
+    std::array<double, 2> best{ 1e300, 1e300 };
+    for (int run = 0; run < 15; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best[0] = std::min(best[0], elapsed.count() / static_cast<double>(rows));
+
+        start = std::chrono::steady_clock::now();
+        g();
+        elapsed = std::chrono::steady_clock::now() - start;
+        best[1] = std::min(best[1], elapsed.count() / static_cast<double>(rows));
+    }
+    return best;
+}
+
+struct scenario
+{
+    const char* name;
+    std::function<double(std::size_t)> first;
+    std::function<double(std::size_t)> others;
+    // the second column has values only where the first one is null
+    bool complementary = false;
+};
+
+int main()
+{
+    const std::size_t rows = 1 << 22;
+    const scenario scenarios[] = {
+        { "first_full", [](std::size_t) { return 0.0; }, [](std::size_t) { return 0.5; } },
+        { "first_99", [](std::size_t) { return 0.01; }, [](std::size_t) { return 0.5; } },
+        { "random_50", [](std::size_t) { return 0.5; }, [](std::size_t) { return 0.5; } },
+        { "null_blocks", [](std::size_t i) { return (i / 4096) % 2 == 0 ? 1.0 : 0.5; },
+            [](std::size_t i) { return (i / 4096) % 2 == 0 ? 1.0 : 0.5; } },
+        { "complementary", [](std::size_t) { return 0.5; }, [](std::size_t) { return 0.5; }, true },
+    };
+
+    std::printf("%-14s %10s %12s %8s  %s\n", "scenario", "batch_ns", "adaptive_ns", "speedup",
+        "fill_default/copy_first/branchy/blend");
+    for (const scenario& s : scenarios)
+    {
+        const column c0{ rows, s.first, 1 };
+        column c1{ rows, s.others, 2 };
+        const column c2{ rows, s.others, 3 };
+        if (s.complementary)
+        {
+            for (std::size_t i = 0; i < rows; ++i)
+                c1.valid[i] = !c0.valid[i];
+        }
+        std::vector<int> out_batch(rows);
+        std::vector<int> out_adaptive(rows);
+        std::vector<s4::adaptive_kernel> choices(s4::value_or_adaptive_blocks(rows));
+
+        const auto [batch, adaptive] = time_per_row(rows, [&]()
+        {
+            s4::value_or_batch(-1, std::span(out_batch), c0.view(), c1.view(), c2.view());
+        }, [&]()
+        {
+            s4::value_or_adaptive(-1, std::span(out_adaptive), std::span(choices), c0.view(), c1.view(), c2.view());
+        });
+
+        if (out_batch != out_adaptive)
+        {
+            std::printf("different results for %s\n", s.name);
+            return 1;
+        }
+        std::array<std::size_t, 4> kernels{};
+        for (s4::adaptive_kernel k : choices)
+            ++kernels[static_cast<std::size_t>(k)];
+        std::printf("%-14s %10.3f %12.3f %8.2f  %zu/%zu/%zu/%zu\n", s.name, batch, adaptive, batch / adaptive,
+            kernels[0], kernels[1], kernels[2], kernels[3]);
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**********************************************************************
+ * \file   bench_branchless.cpp
+ * \brief  Benchmark of value_or and value_or_branchless on rows of
+ *         three std::optional<int>, for growing probabilities of null.
+ *         With a null probability near 0 or 1 the branches of
+ *         value_or are predicted and it is as fast as the branchless
+ *         version; near 0.5 the mispredictions make it slower.
+ *
+ *         build: g++ -std=c++20 -O2 bench_branchless.cpp
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_branchless.h"
+
+
+using column = std::vector<std::optional<int>>;
+
+column make_column(std::size_t rows, double null_probability, unsigned seed)
+{
+    std::mt19937 gen{ seed };
+    std::bernoulli_distribution null{ null_probability };
+    column r(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        if (!null(gen))
+            r[i] = static_cast<int>(i & 0xFF);
+    }
+    return r;
+}
+
+/**
+ * It returns the best time, in nanoseconds per row, of f over the rows,
+ * and writes the sum of the results in sum.
+ */
+template<typename F>
+double time_per_row(std::size_t rows, F f, long long& sum)
+{
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        long long s = 0;
+        for (std::size_t i = 0; i < rows; ++i)
+            s += f(i);
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(rows));
+        sum = s;
+    }
+    return best;
+}
+
+int main()
+{
+    const std::size_t rows = 1 << 22;
+
+    std::printf("%-10s %12s %12s %8s\n", "null_prob", "branchy_ns", "branchless_ns", "speedup");
+    for (double p : { 0.0, 0.01, 0.05, 0.1, 0.2, 0.3, 0.5, 0.7, 0.9, 1.0 })
+    {
+        const column c0 = make_column(rows, p, 1);
+        const column c1 = make_column(rows, p, 2);
+        const column c2 = make_column(rows, p, 3);
+
+        long long sum_branchy = 0;
+        long long sum_branchless = 0;
+        const double branchy = time_per_row(rows,
+            [&](std::size_t i) { return s4::value_or(-1, c0[i], c1[i], c2[i]); }, sum_branchy);
+        const double branchless = time_per_row(rows,
+            [&](std::size_t i) { return s4::value_or_branchless(-1, c0[i], c1[i], c2[i]); }, sum_branchless);
+
+        if (sum_branchy != sum_branchless)
+        {
+            std::printf("different results for null probability %g\n", p);
+            return 1;
+        }
+        std::printf("%-10g %12.3f %12.3f %8.2f\n", p, branchy, branchless, branchy / branchless);
+    }
+    return 0;
+}
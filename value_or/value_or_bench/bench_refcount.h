@@ -0,0 +1,215 @@
+/**********************************************************************
+ * \file   bench_refcount.h
+ * \brief  Body of the benchmark of the reference counters of the
+ *         value holders: std::shared_ptr is passed by value to
+ *         value_or and std::weak_ptr is locked, both are atomic
+ *         operations on the control block. It runs value_or on 1..N
+ *         threads with a holder shared by all the threads and with a
+ *         holder for each thread (a control block for each cache
+ *         line), and prints the throughput.
+ *         It is included by bench_refcount_header.cpp,
+ *         bench_refcount_ex.cpp and bench_refcount_module.cpp after
+ *         their version of value_or; S4_BENCH_WEAK enables the
+ *         std::weak_ptr holders (not supported by value_or/value_or.h).
+ *
+ *         The output has a line for each run, with key=value fields:
+ *         line is the cache line of the control block of the holder
+ *         (std::make_shared puts it next to the value), to find it in
+ *         the "Data Address" column of perf c2c:
+ *             perf c2c record -- ./bench_refcount_ex
+ *             perf c2c report --stdio
+ *         The loops are in functions named loop_<holder>, so that
+ *         the symbols of perf show them.
+ *         holder=shared_ptr passes an lvalue std::shared_ptr, that
+ *         value_or tests like a raw pointer; holder=shared_ptr_copy
+ *         passes a copy, that increments and decrements the counter.
+ *
+ *         usage: bench_refcount_xxx [milliseconds per run] [max threads]
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __bench_refcount_H
+#define __bench_refcount_H
+
+#ifndef S4_BENCH_IMPORT_STD
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define S4_BENCH_NOINLINE __declspec(noinline)
+#else
+#define S4_BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+
+namespace s4_bench
+{
+    inline constexpr std::size_t cache_line = 64;
+
+    // the value is on its own cache line, with the control block
+    // of std::make_shared just before it
+    struct alignas(cache_line) padded_int
+    {
+        int value = 0;
+        operator int() const noexcept { return value; }
+    };
+
+    struct alignas(cache_line) counter
+    {
+        std::uint64_t ops = 0;
+    };
+
+    inline std::atomic<bool> stop{ false };
+
+    S4_BENCH_NOINLINE std::uint64_t loop_raw(const padded_int* p)
+    {
+        const std::optional<padded_int> empty;
+        std::uint64_t ops = 0;
+        int sum = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            for (int i = 0; i < 256; ++i)
+                sum += s4::value_or(padded_int{}, empty, p);
+            ops += 256;
+        }
+        return ops + (sum == 1);
+    }
+
+    S4_BENCH_NOINLINE std::uint64_t loop_shared(const std::shared_ptr<padded_int>& p)
+    {
+        const std::optional<padded_int> empty;
+        std::uint64_t ops = 0;
+        int sum = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            for (int i = 0; i < 256; ++i)
+                sum += s4::value_or(padded_int{}, empty, p);
+            ops += 256;
+        }
+        return ops + (sum == 1);
+    }
+
+    // the caller passes a copy, like value_or(d, get_config()) with a
+    // get_config() that returns a std::shared_ptr by value
+    S4_BENCH_NOINLINE std::uint64_t loop_shared_copy(const std::shared_ptr<padded_int>& p)
+    {
+        const std::optional<padded_int> empty;
+        std::uint64_t ops = 0;
+        int sum = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            for (int i = 0; i < 256; ++i)
+                sum += s4::value_or(padded_int{}, empty, std::shared_ptr<padded_int>{ p });
+            ops += 256;
+        }
+        return ops + (sum == 1);
+    }
+
+#ifdef S4_BENCH_WEAK
+    S4_BENCH_NOINLINE std::uint64_t loop_weak(const std::weak_ptr<padded_int>& p)
+    {
+        const std::optional<padded_int> empty;
+        std::uint64_t ops = 0;
+        int sum = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            for (int i = 0; i < 256; ++i)
+                sum += s4::value_or(padded_int{}, empty, p);
+            ops += 256;
+        }
+        return ops + (sum == 1);
+    }
+#endif
+
+    /**
+     * It runs loop on threads threads for duration, holder(t) is the holder of
+     * the thread t, and prints a line of results; value is the value of the
+     * holder of the thread 0.
+     */
+    template<typename Holder, typename Loop>
+    void run(const char* variant, const char* holder_name, const char* sharing, std::size_t threads,
+        std::chrono::milliseconds duration, const padded_int* value, Holder holder, Loop loop)
+    {
+        std::vector<counter> counters(threads);
+        stop = false;
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+                workers.emplace_back([&, t]() { counters[t].ops = loop(holder(t)); });
+            std::this_thread::sleep_for(duration);
+            stop = true;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::uint64_t ops = 0;
+        for (const counter& c : counters)
+            ops += c.ops;
+        const double ops_per_second = static_cast<double>(ops) / elapsed.count();
+
+        std::printf("variant=%s holder=%s sharing=%s threads=%zu mops=%.2f ns_per_op_per_thread=%.3f line=%p\n",
+            variant, holder_name, sharing, threads, ops_per_second / 1e6,
+            1e9 * static_cast<double>(threads) / ops_per_second,
+            reinterpret_cast<void*>((reinterpret_cast<std::uintptr_t>(value) - 1) & ~(cache_line - 1)));
+        std::fflush(stdout);
+    }
+
+    inline int main(const char* variant, int argc, char** argv)
+    {
+        const std::chrono::milliseconds duration{ argc > 1 ? std::atoi(argv[1]) : 200 };
+        const std::size_t max_threads = argc > 2
+            ? static_cast<std::size_t>(std::atoi(argv[2]))
+            : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+        std::vector<std::size_t> thread_counts;
+        for (std::size_t t = 1; t < max_threads; t *= 2)
+            thread_counts.push_back(t);
+        thread_counts.push_back(max_threads);
+
+        const auto shared = std::make_shared<padded_int>(padded_int{ 1 });
+        std::vector<std::shared_ptr<padded_int>> own;
+        for (std::size_t t = 0; t < max_threads; ++t)
+            own.push_back(std::make_shared<padded_int>(padded_int{ 1 }));
+#ifdef S4_BENCH_WEAK
+        const std::weak_ptr<padded_int> shared_weak = shared;
+        const std::vector<std::weak_ptr<padded_int>> own_weak(own.begin(), own.end());
+#endif
+
+        for (std::size_t threads : thread_counts)
+        {
+            run(variant, "raw", "shared", threads, duration, shared.get(),
+                [&](std::size_t) { return shared.get(); }, loop_raw);
+            run(variant, "shared_ptr", "shared", threads, duration, shared.get(),
+                [&](std::size_t) -> const std::shared_ptr<padded_int>& { return shared; }, loop_shared);
+            run(variant, "shared_ptr", "per_thread", threads, duration, own[0].get(),
+                [&](std::size_t t) -> const std::shared_ptr<padded_int>& { return own[t]; }, loop_shared);
+            run(variant, "shared_ptr_copy", "shared", threads, duration, shared.get(),
+                [&](std::size_t) -> const std::shared_ptr<padded_int>& { return shared; }, loop_shared_copy);
+            run(variant, "shared_ptr_copy", "per_thread", threads, duration, own[0].get(),
+                [&](std::size_t t) -> const std::shared_ptr<padded_int>& { return own[t]; }, loop_shared_copy);
+#ifdef S4_BENCH_WEAK
+            run(variant, "weak_ptr", "shared", threads, duration, shared.get(),
+                [&](std::size_t) -> const std::weak_ptr<padded_int>& { return shared_weak; },
+                [](const std::weak_ptr<padded_int>& p) { return loop_weak(p); });
+            run(variant, "weak_ptr", "per_thread", threads, duration, own[0].get(),
+                [&](std::size_t t) -> const std::weak_ptr<padded_int>& { return own_weak[t]; },
+                [](const std::weak_ptr<padded_int>& p) { return loop_weak(p); });
+#endif
+        }
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,20 @@
+/**********************************************************************
+ * \file   bench_refcount_ex.cpp
+ * \brief  Benchmark of the reference counters with value_or_ex/value_or.h,
+ *         see bench_refcount.h.
+ *
+ *         build: g++ -std=c++20 -O2 -pthread bench_refcount_ex.cpp
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#define S4_BENCH_WEAK
+#include "../value_or_ex/value_or.h"
+#include "bench_refcount.h"
+
+
+int main(int argc, char** argv)
+{
+    return s4_bench::main("ex", argc, argv);
+}
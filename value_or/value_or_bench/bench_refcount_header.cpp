@@ -0,0 +1,19 @@
+/**********************************************************************
+ * \file   bench_refcount_header.cpp
+ * \brief  Benchmark of the reference counters with value_or/value_or.h,
+ *         see bench_refcount.h.
+ *
+ *         build: g++ -std=c++20 -O2 -pthread bench_refcount_header.cpp
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#include "../value_or/value_or.h"
+#include "bench_refcount.h"
+
+
+int main(int argc, char** argv)
+{
+    return s4_bench::main("header", argc, argv);
+}
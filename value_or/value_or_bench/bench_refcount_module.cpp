@@ -0,0 +1,23 @@
+/**********************************************************************
+ * \file   bench_refcount_module.cpp
+ * \brief  Benchmark of the reference counters with the module
+ *         s4.value_or (value_or_ex_module/s4.value_or.ixx), see
+ *         bench_refcount.h. It needs a compiler that supports the
+ *         modules and import std, for example MSVC with /std:c++latest
+ *         and s4.value_or.ixx in the same project.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#define S4_BENCH_WEAK
+#define S4_BENCH_IMPORT_STD
+import std;
+import s4.value_or;
+#include "bench_refcount.h"
+
+
+int main(int argc, char** argv)
+{
+    return s4_bench::main("module", argc, argv);
+}
@@ -0,0 +1,99 @@
+/**********************************************************************
+ * \file   bench_rules.cpp
+ * \brief  Benchmark of coalesce_rule against the same coalesce written
+ *         with value_or_batch_projected, for growing probabilities of
+ *         null: coalesce(A, B * 1000, C, 0) on columns of int.
+ *         The rule is interpreted a block at a time, so it should
+ *         stay close to the compiled batch.
+ *
+ *         build: g++ -std=c++20 -O2 bench_rules.cpp
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "../value_or_ex/value_or_project.h"
+#include "../value_or_ex/value_or_rules.h"
+
+
+struct column
+{
+    std::vector<int> values;
+    std::vector<std::uint8_t> valid;
+
+    column(std::size_t rows, double null_probability, unsigned seed)
+        : values(rows), valid(rows)
+    {
+        std::mt19937 gen{ seed };
+        std::bernoulli_distribution null{ null_probability };
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            values[i] = static_cast<int>(i & 0xFF);
+            valid[i] = !null(gen);
+        }
+    }
+
+    s4::nullable_column<int> view() const
+    {
+        return { values, valid };
+    }
+};
+
+/**
+ * It returns the best time, in nanoseconds per row, of f.
+ */
+template<typename F>
+double time_per_row(std::size_t rows, F f)
+{
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(rows));
+    }
+    return best;
+}
+
+int main()
+{
+    const std::size_t rows = 1 << 22;
+    constexpr std::string_view names[] = { "A", "B", "C" };
+    const auto rule = s4::coalesce_rule<int>::compile("coalesce(A, B * 1000, C, 0)", names);
+
+    std::printf("%-10s %12s %12s %8s\n", "null_prob", "batch_ns", "rule_ns", "ratio");
+    for (double p : { 0.0, 0.1, 0.5, 0.9, 1.0 })
+    {
+        const column a{ rows, p, 1 };
+        const column b{ rows, p, 2 };
+        const column c{ rows, p, 3 };
+        const s4::nullable_column<int> columns[] = { a.view(), b.view(), c.view() };
+        std::vector<int> out_batch(rows);
+        std::vector<int> out_rule(rows);
+
+        const double batch = time_per_row(rows, [&]()
+        {
+            s4::value_or_batch_projected(0, std::span(out_batch), columns[0],
+                s4::project_column(columns[1], s4::affine<int>{ 1000, 0 }), columns[2]);
+        });
+        const double interpreted = time_per_row(rows, [&]() { rule.run(0, out_rule, columns); });
+
+        if (out_batch != out_rule)
+        {
+            std::printf("different results for null probability %g\n", p);
+            return 1;
+        }
+        std::printf("%-10g %12.3f %12.3f %8.2f\n", p, batch, interpreted, interpreted / batch);
+    }
+    return 0;
+}
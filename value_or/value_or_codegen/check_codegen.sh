@@ -0,0 +1,115 @@
+#!/bin/sh
+#######################################################################
+# \file   check_codegen.sh
+# \brief  It compiles codegen_patterns.cpp with GCC and Clang at -O2
+#         and -O3, disassembles it with objdump and compares each
+#         lib_<name> function with manual_<name>.
+#         The check fails if the value_or version has more conditional
+#         branches, calls or locked (reference counter) instructions
+#         than the hand-written code. The instruction counts are
+#         printed for the review.
+#
+#         usage: check_codegen.sh [compiler...]
+#         default compilers: g++ clang++ (the missing ones are skipped)
+#
+# \author Roberto
+# \date   October 2026
+#######################################################################
+
+set -u
+
+dir=$(cd "$(dirname "$0")" && pwd)
+src="$dir/codegen_patterns.cpp"
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+compilers=${*:-"g++ clang++"}
+status=0
+checked=0
+
+# It prints, for every function of the object file:
+# name instructions branches calls locks
+# padding nops are not counted, a jmp to another function is a (tail) call,
+# the cold part of a function (name.cold) is counted with the function
+metrics()
+{
+    objdump -d --no-show-raw-insn "$1" | awk '
+        /^[0-9a-f]+ <[^>]+>:$/ {
+            if (name != "") print name, insns, branches, calls, locks
+            name = substr($2, 2, length($2) - 3)
+            base = name
+            sub(/\.cold$/, "", base)
+            insns = branches = calls = locks = 0
+            next
+        }
+        name != "" && /^ +[0-9a-f]+:\t/ {
+            line = $0
+            sub(/^ +[0-9a-f]+:\t/, "", line)
+            split(line, op, /[ \t]+/)
+            m = op[1]
+            if (m ~ /^(nop|data16|cs|xchg %ax,%ax)/) next
+            insns++
+            if (m == "lock") { locks++; m = op[2] }
+            if (m ~ /^call/) calls++
+            else if (m ~ /^jmp/) { if (line !~ ("<" base "[+.>]")) calls++ }
+            else if (m ~ /^j/) branches++
+        }
+        END { if (name != "") print name, insns, branches, calls, locks }
+    ' | awk '
+        { sub(/\.cold$/, "", $1); i[$1] += $2; b[$1] += $3; c[$1] += $4; l[$1] += $5 }
+        END { for (n in i) print n, i[n], b[n], c[n], l[n] }
+    ' | sort
+}
+
+for cxx in $compilers
+do
+    if ! command -v "$cxx" > /dev/null 2>&1
+    then
+        echo "skip $cxx: not found"
+        continue
+    fi
+
+    for opt in -O2 -O3
+    do
+        obj="$tmp/patterns.o"
+        if ! "$cxx" -std=c++20 $opt -DNDEBUG -c "$src" -o "$obj"
+        then
+            echo "FAIL $cxx $opt: compilation error"
+            status=1
+            continue
+        fi
+        metrics "$obj" > "$tmp/metrics.txt"
+
+        for lib in $(awk '$1 ~ /^lib_/ { print $1 }' "$tmp/metrics.txt")
+        do
+            name=${lib#lib_}
+            set -- $(awk -v n="$lib" '$1 == n { print $2, $3, $4, $5 }' "$tmp/metrics.txt")
+            li=$1 lb=$2 lc=$3 ll=$4
+            set -- $(awk -v n="manual_$name" '$1 == n { print $2, $3, $4, $5 }' "$tmp/metrics.txt")
+            if [ $# -ne 4 ]
+            then
+                echo "FAIL $cxx $opt $name: manual_$name not found"
+                status=1
+                continue
+            fi
+            mi=$1 mb=$2 mc=$3 ml=$4
+
+            result=ok
+            if [ "$lb" -gt "$mb" ] || [ "$lc" -gt "$mc" ] || [ "$ll" -gt "$ml" ]
+            then
+                result=FAIL
+                status=1
+            fi
+            checked=$((checked + 1))
+            printf '%-4s %-8s %s %-18s insns %3d/%-3d branches %d/%d calls %d/%d locks %d/%d (lib/manual)\n' \
+                "$result" "$cxx" "$opt" "$name" "$li" "$mi" "$lb" "$mb" "$lc" "$mc" "$ll" "$ml"
+        done
+    done
+done
+
+if [ "$checked" -eq 0 ]
+then
+    echo "FAIL: no pattern checked"
+    exit 1
+fi
+exit $status
@@ -0,0 +1,110 @@
+/**********************************************************************
+ * \file   codegen_patterns.cpp
+ * \brief  Call patterns of value_or, each one next to the hand-written
+ *         code it is equivalent to. check_codegen.sh compiles this file
+ *         and compares the instructions of every lib_<name> function
+ *         with the ones of manual_<name>.
+ *         The functions are extern "C" to find them in the disassembly
+ *         without demangling.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "../value_or_ex/value_or.h"
+
+
+extern "C"
+{
+    // r0a/r0b of examples_ex.cpp: raw pointer and unique_ptr
+    int lib_r0(const int* pi, const std::unique_ptr<int>& up, const int i)
+    {
+        return s4::value_or(i, pi, up);
+    }
+
+    int manual_r0(const int* pi, const std::unique_ptr<int>& up, const int i)
+    {
+        return !pi ? (!up ? i : *up) : *pi;
+    }
+
+
+    // r14 of examples_ex.cpp: optional and shared_ptr
+    int lib_r14(const int def_from_user, const std::optional<int>& on, const std::shared_ptr<int>& sn)
+    {
+        return s4::value_or(def_from_user, on, sn);
+    }
+
+    int manual_r14(const int def_from_user, const std::optional<int>& on, const std::shared_ptr<int>& sn)
+    {
+        return !on ? (!sn ? def_from_user : *sn) : *on;
+    }
+
+
+    // shared_ptr and raw pointer
+    int lib_shared(const std::shared_ptr<int>& sp, const int* p, const int d)
+    {
+        return s4::value_or(d, sp, p);
+    }
+
+    int manual_shared(const std::shared_ptr<int>& sp, const int* p, const int d)
+    {
+        return !sp ? (!p ? d : *p) : *sp;
+    }
+
+
+    // prvalue shared_ptr: the by-value overload must move it, not copy it,
+    // so both versions release the reference once and never increment it
+    int lib_shared_prvalue(std::shared_ptr<int> (*make)(), const int* p, const int d)
+    {
+        return s4::value_or(d, make(), p);
+    }
+
+    int manual_shared_prvalue(std::shared_ptr<int> (*make)(), const int* p, const int d)
+    {
+        const std::shared_ptr<int> sp = make();
+        return !sp ? (!p ? d : *p) : *sp;
+    }
+
+
+    // weak_ptr: both versions must lock it
+    int lib_weak(const std::weak_ptr<int>& wp, const int d)
+    {
+        return s4::value_or(d, wp);
+    }
+
+    int manual_weak(const std::weak_ptr<int>& wp, const int d)
+    {
+        if (auto sp = wp.lock())
+            return *sp;
+        return d;
+    }
+
+
+    // pointer to function as source
+    int lib_callable(const int* (*f)(), const std::optional<int>& o, const int d)
+    {
+        return s4::value_or(d, f, o);
+    }
+
+    int manual_callable(const int* (*f)(), const std::optional<int>& o, const int d)
+    {
+        const int* p = !f ? nullptr : f();
+        return !p ? (!o ? d : *o) : *p;
+    }
+
+
+    // pointer to function as default value
+    int lib_callable_default(int (*calc)(), const int* p)
+    {
+        return s4::value_or(calc, p);
+    }
+
+    int manual_callable_default(int (*calc)(), const int* p)
+    {
+        return !p ? calc() : *p;
+    }
+}
@@ -0,0 +1,15 @@
+/**********************************************************************
+ * \file   common_instances.cpp
+ * \brief  Instantiation translation unit of value_or_canonical for
+ *         the list S4_VALUE_OR_COMMON_INSTANCES of
+ *         value_or_common_instances.h, that declares them extern in
+ *         the other translation units.
+ *         size_report.sh prints the size of each instance.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#include "../value_or_ex/value_or_common_instances.h"
+
+S4_VALUE_OR_COMMON_INSTANCES(S4_VALUE_OR_INSTANTIATE)
@@ -0,0 +1,56 @@
+#!/bin/sh
+#######################################################################
+# \file   size_report.sh
+# \brief  It prints the code size of every function of namespace s4
+#         in the object files of the given sources, largest first,
+#         and the total of each object file: the size of each
+#         instantiation of value_or that is not inlined.
+#
+#         usage: size_report.sh [source...]
+#         default source: common_instances.cpp
+#         CXX (default g++) and CXXFLAGS (default -O2) select the
+#         compiler and the options, for example CXXFLAGS=-O0 shows
+#         all the instantiations.
+#
+# \author Roberto
+# \date   October 2026
+#######################################################################
+
+set -u
+
+dir=$(cd "$(dirname "$0")" && pwd)
+cxx=${CXX:-g++}
+flags=${CXXFLAGS:--O2}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+if [ $# -eq 0 ]
+then
+    set -- "$dir/common_instances.cpp"
+fi
+
+status=0
+for src in "$@"
+do
+    obj="$tmp/$(basename "$src").o"
+    if ! $cxx -std=c++20 $flags -c "$src" -o "$obj"
+    then
+        echo "FAIL $src: compilation error"
+        status=1
+        continue
+    fi
+
+    echo "# $src ($cxx $flags)"
+    # the code symbols (t, T, W) of s4 with their size in bytes
+    nm -C -S --size-sort -t d "$obj" | awk '
+        $3 ~ /^[tTwW]$/ && $0 ~ /s4::/ {
+            name = $0
+            sub(/^[^ ]+ [^ ]+ [^ ]+ /, "", name)
+            printf "%8d  %s\n", $2 + 0, name
+        }
+    ' | sort -k1,1nr | awk '
+        { print; total += $1; count++ }
+        END { printf "%8d  total (%d functions)\n", total, count }
+    '
+done
+exit $status
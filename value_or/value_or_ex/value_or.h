@@ -20,6 +20,8 @@
 #include <concepts>
 #include <memory>
 
+#include "value_or_usdt.h"
+
 
 namespace s4 // Small Simple Stupid Stuff namespace 
 {
@@ -209,6 +211,7 @@ namespace s4 // Small Simple Stupid Stuff namespace
             && (!std::invocable<DT>)
         [[nodiscard]] constexpr decltype(auto) value_or(DT&& default_value)
         {
+            usdt_impl::fallback();
             return static_cast<RT>(default_value);
         }
 
@@ -224,7 +227,8 @@ namespace s4 // Small Simple Stupid Stuff namespace
             && std::invocable<DT>
         [[nodiscard]] constexpr decltype(auto) value_or(DT&& default_value)
         {
-            return default_value();
+            usdt_impl::fallback();
+            return usdt_impl::call(-1, default_value);
         }
 
                   
@@ -238,7 +242,7 @@ namespace s4 // Small Simple Stupid Stuff namespace
                     ? value_or<RT, DT, Args...>(
                         std::forward<DT>(default_value),
                         std::forward<Args>(to_test_v)...)
-                    : static_cast<RT>(*to_test_0);
+                    : (usdt_impl::hit(sizeof...(Args)), static_cast<RT>(*to_test_0));
         }
 
         
@@ -248,7 +252,10 @@ namespace s4 // Small Simple Stupid Stuff namespace
         [[nodiscard]] constexpr std::remove_reference_t<RT> value_or(DT&& default_value, PT&& to_test_0, Args&&... to_test_v)
         {
             if (auto t = to_test_0.lock())
+            {
+                usdt_impl::hit(sizeof...(Args));
                 return *t;
+            }
             else
                 return value_or<RT, DT, Args...>(
                     std::forward<DT>(default_value),
@@ -265,7 +272,7 @@ namespace s4 // Small Simple Stupid Stuff namespace
                 ? value_or<RT, DT, Args...>(
                     std::forward<DT>(default_value),
                     std::forward<Args>(to_test_v)...)
-                : static_cast<RT>(*to_test_0);
+                : (usdt_impl::hit(sizeof...(Args)), static_cast<RT>(*to_test_0));
         }
                
 
@@ -275,7 +282,7 @@ namespace s4 // Small Simple Stupid Stuff namespace
         {
             return value_or<RT, DT, std::invoke_result_t<PT>, Args...>(
                 std::forward<DT>(default_value),
-                std::forward<std::invoke_result_t<PT>>(to_test_0()),
+                std::forward<std::invoke_result_t<PT>>(usdt_impl::call(sizeof...(Args), to_test_0)),
                 std::forward<Args>(to_test_v)...);
         }
         
@@ -295,7 +302,7 @@ namespace s4 // Small Simple Stupid Stuff namespace
             {
                 return value_or<RT, DT, std::invoke_result_t<PT>, Args...>(
                     std::forward<DT>(default_value),
-                    std::forward<std::invoke_result_t<PT>>(to_test_0()),
+                    std::forward<std::invoke_result_t<PT>>(usdt_impl::call(sizeof...(Args), to_test_0)),
                     std::forward<Args>(to_test_v)...);
             }
         }
@@ -0,0 +1,310 @@
+/**********************************************************************
+ * \file   value_or_adaptive.h
+ * \brief  It contains the adaptive version of value_or_batch:
+ *         value_or_adaptive(default_value, out, choices, columns...)
+ *         chooses for every block of rows the kernel that suits the
+ *         data of the block:
+ *         fill_default, if all the columns of the block are null,
+ *         copy_first, if the first column has all the values,
+ *         branchy, an early exit loop, if the column that supplies
+ *         the value is almost always the same one, so the branches
+ *         are predicted,
+ *         blend, the vectorized selects with masks of value_or_batch,
+ *         if the presence is random; the columns that are null in the
+ *         whole block are skipped, and so are the columns after the
+ *         ones that together have a value in every row of the block.
+ *         The choice looks at one row every sample_stride rows, and
+ *         for each sampled row at all the columns: the sample gives
+ *         the density of each column and which column wins each
+ *         row, so it sees also how the nulls of the columns are
+ *         correlated (a column that has values only where an earlier
+ *         column has them never wins). The exact checks of
+ *         fill_default, copy_first and of the columns to skip read
+ *         the valid flags 8 at a time, and they are done only if the
+ *         sample suggests them. The kernel chosen for each block is
+ *         written in choices, to inspect the choices.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_adaptive_H
+#define __value_or_adaptive_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "value_or_batch.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Kernel used by value_or_adaptive for a block of rows.
+     */
+    enum class adaptive_kernel : std::uint8_t
+    {
+        fill_default,
+        copy_first,
+        branchy,
+        blend,
+    };
+
+    [[nodiscard]] constexpr std::string_view to_string(adaptive_kernel kernel) noexcept
+    {
+        switch (kernel)
+        {
+        case adaptive_kernel::fill_default: return "fill_default";
+        case adaptive_kernel::copy_first: return "copy_first";
+        case adaptive_kernel::branchy: return "branchy";
+        case adaptive_kernel::blend: return "blend";
+        }
+        return "unknown";
+    }
+
+
+    namespace adaptive_impl
+    {
+        using value_or_batch_impl::block_rows;
+        using value_or_batch_impl::select;
+
+        // one row every sample_stride rows is sampled
+        inline constexpr std::size_t sample_stride = 16;
+
+        // min share of the sampled rows resolved by the same column to use branchy
+        inline constexpr std::size_t branchy_share_percent = 90;
+
+        template<typename T, std::size_t N>
+        using columns_t = std::array<const nullable_column<T>*, N>;
+
+        [[nodiscard]] inline std::uint64_t load_word(const std::uint8_t* p) noexcept
+        {
+            std::uint64_t w;
+            std::memcpy(&w, p, sizeof(w));
+            return w;
+        }
+
+        [[nodiscard]] constexpr bool has_zero_byte(std::uint64_t w) noexcept
+        {
+            return ((w - 0x0101010101010101ull) & ~w & 0x8080808080808080ull) != 0;
+        }
+
+        [[nodiscard]] inline bool all_null(const std::uint8_t* valid, std::size_t rows) noexcept
+        {
+            std::uint64_t any = 0;
+            std::size_t i = 0;
+            for (; i + 8 <= rows; i += 8)
+                any |= load_word(valid + i);
+            for (; i < rows; ++i)
+                any |= valid[i];
+            return any == 0;
+        }
+
+        /**
+         * It returns true if at least one of the first m columns has a value
+         * in every row of the block.
+         */
+        template<typename T, std::size_t N>
+        [[nodiscard]] bool covered(const columns_t<T, N>& columns, std::size_t m, std::size_t begin, std::size_t rows) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + 8 <= rows; i += 8)
+            {
+                std::uint64_t any = 0;
+                for (std::size_t k = 0; k < m; ++k)
+                    any |= load_word(columns[k]->valid.data() + begin + i);
+                if (has_zero_byte(any))
+                    return false;
+            }
+            for (; i < rows; ++i)
+            {
+                std::uint8_t any = 0;
+                for (std::size_t k = 0; k < m; ++k)
+                    any |= columns[k]->valid[begin + i];
+                if (any == 0)
+                    return false;
+            }
+            return true;
+        }
+
+        /**
+         * It chooses the kernel of the block [begin, begin + rows), and sets
+         * skip[k] for the columns that blend does not need.
+         */
+        template<typename T, std::size_t N>
+        [[nodiscard]] adaptive_kernel choose(const columns_t<T, N>& columns, std::size_t begin, std::size_t rows,
+            std::array<bool, N>& skip) noexcept
+        {
+            // column that supplies the value of each sampled row, N for the default
+            std::array<std::size_t, N + 1> winners{};
+            std::array<std::size_t, N> valid{};
+            std::size_t samples = 0;
+            for (std::size_t i = begin; i < begin + rows; i += sample_stride)
+            {
+                std::size_t winner = N;
+                for (std::size_t k = N; k-- > 0; )
+                {
+                    const bool v = columns[k]->valid[i] != 0;
+                    valid[k] += v;
+                    winner = v ? k : winner;
+                }
+                ++winners[winner];
+                ++samples;
+            }
+
+            std::size_t present = 0;
+            for (std::size_t k = 0; k < N; ++k)
+            {
+                skip[k] = valid[k] == 0 && all_null(columns[k]->valid.data() + begin, rows);
+                present += !skip[k];
+            }
+            if (present == 0)
+                return adaptive_kernel::fill_default;
+            if (valid[0] == samples && covered(columns, 1, begin, rows))
+                return adaptive_kernel::copy_first;
+            if (*std::max_element(winners.begin(), winners.end()) * 100 >= samples * branchy_share_percent)
+                return adaptive_kernel::branchy;
+
+            // the columns after the last winner of the sample are not needed
+            // if the columns up to it cover the block
+            if (winners[N] == 0)
+            {
+                std::size_t needed = N;
+                while (needed > 1 && winners[needed - 1] == 0)
+                    --needed;
+                if (needed < N && covered(columns, needed, begin, rows))
+                {
+                    for (std::size_t k = needed; k < N; ++k)
+                        skip[k] = true;
+                }
+            }
+            return adaptive_kernel::blend;
+        }
+
+        template<typename T, std::size_t N>
+        void branchy(const T& default_value, const columns_t<T, N>& columns, std::size_t begin, std::size_t rows,
+            T* out) noexcept
+        {
+            for (std::size_t i = begin; i < begin + rows; ++i)
+            {
+                T v = default_value;
+                for (std::size_t k = 0; k < N; ++k)
+                {
+                    if (columns[k]->valid[i] != 0)
+                    {
+                        v = columns[k]->values[i];
+                        break;
+                    }
+                }
+                out[i - begin] = v;
+            }
+        }
+
+        template<typename T, std::size_t N>
+        void blend(const T& default_value, const columns_t<T, N>& columns, const std::array<bool, N>& skip,
+            std::size_t begin, std::size_t rows, T* out) noexcept
+        {
+            for (std::size_t i = 0; i < rows; ++i)
+                out[i] = default_value;
+
+            for (std::size_t k = N; k-- > 0; )
+            {
+                if (skip[k])
+                    continue;
+                const T* values = columns[k]->values.data() + begin;
+                const std::uint8_t* valid = columns[k]->valid.data() + begin;
+                for (std::size_t i = 0; i < rows; ++i)
+                    out[i] = select(valid[i] != 0, values[i], out[i]);
+            }
+        }
+
+        template<typename T, std::size_t N>
+        void value_or_adaptive(const T& default_value, const columns_t<T, N>& columns, std::span<T> out,
+            std::span<adaptive_kernel> choices) noexcept
+        {
+            static_assert(N <= value_or_batch_impl::max_columns, "too many columns");
+
+            for (std::size_t begin = 0, block = 0; begin < out.size(); begin += block_rows, ++block)
+            {
+                const std::size_t rows = std::min(block_rows, out.size() - begin);
+                std::array<bool, N> skip{};
+                const adaptive_kernel kernel = choose(columns, begin, rows, skip);
+                T* block_out = out.data() + begin;
+
+                switch (kernel)
+                {
+                case adaptive_kernel::fill_default:
+                    std::fill_n(block_out, rows, default_value);
+                    break;
+                case adaptive_kernel::copy_first:
+                    std::copy_n(columns[0]->values.data() + begin, rows, block_out);
+                    break;
+                case adaptive_kernel::branchy:
+                    branchy(default_value, columns, begin, rows, block_out);
+                    break;
+                case adaptive_kernel::blend:
+                    blend(default_value, columns, skip, begin, rows, block_out);
+                    break;
+                }
+                if (block < choices.size())
+                    choices[block] = kernel;
+            }
+        }
+    }
+
+
+    /**
+     * It returns the number of blocks of value_or_adaptive for rows rows, the
+     * size of its choices.
+     */
+    [[nodiscard]] constexpr std::size_t value_or_adaptive_blocks(std::size_t rows) noexcept
+    {
+        return (rows + adaptive_impl::block_rows - 1) / adaptive_impl::block_rows;
+    }
+
+    /**
+     * Version of value_or_batch that chooses the kernel of each block of rows
+     * from a sample of the block, and writes the kernel chosen for each block
+     * in choices.
+     * All the columns must have at least out.size() rows.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param out Coalesced column
+     * \param choices Kernel of each block, value_or_adaptive_blocks(out.size()) elements, or an empty span
+     * \param to_test_0 First column to check
+     * \param ...to_test_v Next columns to check
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    void value_or_adaptive(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        std::span<adaptive_kernel> choices, const nullable_column<T>& to_test_0, const Columns&... to_test_v) noexcept
+    {
+        adaptive_impl::value_or_adaptive<T, 1 + sizeof...(Columns)>(
+            default_value, { &to_test_0, &to_test_v... }, out, choices);
+    }
+
+    /**
+     * value_or_adaptive without the choices.
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    void value_or_adaptive(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v) noexcept
+    {
+        adaptive_impl::value_or_adaptive<T, 1 + sizeof...(Columns)>(
+            default_value, { &to_test_0, &to_test_v... }, out, {});
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,453 @@
+/**********************************************************************
+ * \file   value_or_batch.h
+ * \brief  It contains the batch version of value_or: the values to
+ *         test are columns of nullable values (nullable_column), and
+ *         value_or is applied to every row of the columns.
+ *         value_or_batch(default_value, out, columns...) writes the
+ *         coalesced column in out, arg_value_or_batch writes also
+ *         the index of the column that supplied each value.
+ *         value_or_reduce, value_or_sum, ... reduce the coalesced
+ *         column in the same pass, without writing it.
+ *         The rows are resolved a block at a time, without branches,
+ *         so that the compiler can vectorize the loops.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_batch_H
+#define __value_or_batch_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Column of nullable values: values[i] has a value only if valid[i] != 0.
+     * If valid[i] == 0 then values[i] is read, but not used: it must be
+     * a valid object of type T.
+     */
+    template<typename T>
+    struct nullable_column
+    {
+        std::span<const T> values;
+        std::span<const std::uint8_t> valid;
+    };
+
+    /**
+     * Index written by arg_value_or_batch for the rows where no column has
+     * a value, and the default value is used.
+     */
+    inline constexpr std::uint8_t value_or_default_index = 0xFF;
+
+
+    namespace value_or_batch_impl
+    {
+        // number of rows resolved by each step, the block stays in the L1 cache
+        inline constexpr std::size_t block_rows = 512;
+
+        // max number of columns, value_or_default_index is not a valid index
+        inline constexpr std::size_t max_columns = value_or_default_index;
+
+        template<std::size_t Size> struct unsigned_of_size;
+        template<> struct unsigned_of_size<1> { using type = std::uint8_t; };
+        template<> struct unsigned_of_size<2> { using type = std::uint16_t; };
+        template<> struct unsigned_of_size<4> { using type = std::uint32_t; };
+        template<> struct unsigned_of_size<8> { using type = std::uint64_t; };
+
+        /**
+         * It returns s ? a : b without branches. For arithmetic types the
+         * selection is done with a mask, because the compilers vectorize
+         * the mask also with SSE2, the ternary operator only with the blend
+         * instructions of AVX.
+         */
+        template<typename T>
+        [[nodiscard]] constexpr T select(bool s, T a, T b) noexcept
+        {
+            if constexpr (std::is_arithmetic_v<T> && requires { typename unsigned_of_size<sizeof(T)>::type; })
+            {
+                using U = typename unsigned_of_size<sizeof(T)>::type;
+                const U m = static_cast<U>(U{ 0 } - static_cast<U>(s));
+                return std::bit_cast<T>(static_cast<U>(
+                    (std::bit_cast<U>(a) & m) | (std::bit_cast<U>(b) & static_cast<U>(~m))));
+            }
+            else
+            {
+                return s ? a : b;
+            }
+        }
+
+        /**
+         * It resolves the rows [begin, begin + rows) of the columns: acc and win
+         * are initialized with the default value, then the columns are applied
+         * from the last to the first, so that the first column with a value wins.
+         */
+        template<bool Track, typename T, std::size_t N>
+        constexpr void resolve_block(const T& default_value,
+            const std::array<const nullable_column<T>*, N>& columns,
+            std::size_t begin, std::size_t rows, T* acc, std::uint8_t* win) noexcept
+        {
+            for (std::size_t i = 0; i < rows; ++i)
+                acc[i] = default_value;
+            if constexpr (Track)
+            {
+                for (std::size_t i = 0; i < rows; ++i)
+                    win[i] = value_or_default_index;
+            }
+
+            for (std::size_t k = N; k-- > 0; )
+            {
+                const T* values = columns[k]->values.data() + begin;
+                const std::uint8_t* valid = columns[k]->valid.data() + begin;
+                const std::uint8_t index = static_cast<std::uint8_t>(k);
+
+                for (std::size_t i = 0; i < rows; ++i)
+                {
+                    const bool s = valid[i] != 0;
+                    acc[i] = select(s, values[i], acc[i]);
+                    if constexpr (Track)
+                        win[i] = select(s, index, win[i]);
+                }
+            }
+        }
+
+        /**
+         * It adds to hits the number of rows won by each column, the last
+         * element of hits is the number of rows resolved with the default value.
+         */
+        template<std::size_t N>
+        constexpr void count_hits(const std::uint8_t* win, std::size_t rows, std::span<std::size_t> hits) noexcept
+        {
+            std::array<std::size_t, N + 1> block_hits{};
+            for (std::size_t i = 0; i < rows; ++i)
+                ++block_hits[std::min<std::size_t>(win[i], N)];
+            for (std::size_t k = 0; k <= N; ++k)
+                hits[k] += block_hits[k];
+        }
+
+        /**
+         * It checks the sizes of winners and hits of arg_value_or_batch:
+         * winners empty or with at least rows elements, hits empty or with
+         * N + 1 elements.
+         */
+        template<std::size_t N>
+        constexpr void check_outputs(std::size_t rows, std::span<std::uint8_t> winners, std::span<std::size_t> hits)
+        {
+            if (!winners.empty() && winners.size() < rows)
+                throw std::invalid_argument("arg_value_or_batch: winners has less rows than out");
+            if (!hits.empty() && hits.size() != N + 1)
+                throw std::invalid_argument("arg_value_or_batch: hits must have number of columns + 1 elements");
+        }
+
+        template<typename T, std::size_t N>
+        constexpr void value_or_batch(const T& default_value,
+            const std::array<const nullable_column<T>*, N>& columns,
+            std::span<T> out, std::span<std::uint8_t> winners, std::span<std::size_t> hits) noexcept
+        {
+            static_assert(N <= max_columns, "too many columns");
+
+            const bool track = !winners.empty() || !hits.empty();
+            T acc[block_rows];
+            std::uint8_t win[block_rows];
+
+            for (std::size_t begin = 0; begin < out.size(); begin += block_rows)
+            {
+                const std::size_t rows = std::min(block_rows, out.size() - begin);
+                if (track)
+                    resolve_block<true>(default_value, columns, begin, rows, acc, win);
+                else
+                    resolve_block<false>(default_value, columns, begin, rows, acc, win);
+
+                std::copy_n(acc, rows, out.data() + begin);
+                if (!winners.empty())
+                    std::copy_n(win, rows, winners.data() + begin);
+                if (!hits.empty())
+                    count_hits<N>(win, rows, hits);
+            }
+        }
+
+        /**
+         * It reduces rows values with op, using 4 accumulators to keep
+         * independent operations in flight. op must be associative and
+         * commutative, the order of the operations is not the order of the rows.
+         */
+        template<typename T, typename Op>
+        [[nodiscard]] constexpr T reduce_block(const T* values, std::size_t rows, T init, Op& op)
+        {
+            std::size_t i = 0;
+            if (rows >= 4)
+            {
+                T r0 = values[0];
+                T r1 = values[1];
+                T r2 = values[2];
+                T r3 = values[3];
+                for (i = 4; i + 4 <= rows; i += 4)
+                {
+                    r0 = op(r0, values[i]);
+                    r1 = op(r1, values[i + 1]);
+                    r2 = op(r2, values[i + 2]);
+                    r3 = op(r3, values[i + 3]);
+                }
+                init = op(init, op(op(r0, r1), op(r2, r3)));
+            }
+            for (; i < rows; ++i)
+                init = op(init, values[i]);
+            return init;
+        }
+
+        /**
+         * It coalesces the columns a block at a time, and reduces each block
+         * while it is in the L1 cache: the coalesced column is never written
+         * to memory.
+         */
+        template<typename T, std::size_t N, typename Op>
+        [[nodiscard]] constexpr T value_or_reduce(const T& default_value,
+            const std::array<const nullable_column<T>*, N>& columns, T init, Op& op)
+        {
+            static_assert(N <= max_columns, "too many columns");
+
+            const std::size_t rows = columns[0]->values.size();
+            T acc[block_rows];
+
+            for (std::size_t begin = 0; begin < rows; begin += block_rows)
+            {
+                const std::size_t block = std::min(block_rows, rows - begin);
+                resolve_block<false>(default_value, columns, begin, block, acc, nullptr);
+                init = reduce_block(acc, block, init, op);
+            }
+            return init;
+        }
+
+        /**
+         * It counts the rows where no column has a value.
+         */
+        template<typename T, std::size_t N>
+        [[nodiscard]] constexpr std::size_t count_default(const std::array<const nullable_column<T>*, N>& columns) noexcept
+        {
+            const std::size_t rows = columns[0]->values.size();
+            std::size_t count = 0;
+            std::uint8_t any[block_rows];
+
+            for (std::size_t begin = 0; begin < rows; begin += block_rows)
+            {
+                const std::size_t block = std::min(block_rows, rows - begin);
+                for (std::size_t i = 0; i < block; ++i)
+                    any[i] = 0;
+                for (std::size_t k = 0; k < N; ++k)
+                {
+                    const std::uint8_t* valid = columns[k]->valid.data() + begin;
+                    for (std::size_t i = 0; i < block; ++i)
+                        any[i] |= valid[i];
+                }
+                for (std::size_t i = 0; i < block; ++i)
+                    count += any[i] == 0;
+            }
+            return count;
+        }
+    }
+
+
+    /**
+     * It applies value_or to every row of the columns: out[i] is the value of
+     * the first column with a value at the row i, default_value if no column
+     * has a value.
+     * All the columns must have at least out.size() rows.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param out Coalesced column
+     * \param to_test_0 First column to check
+     * \param ...to_test_v Next columns to check
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    constexpr void value_or_batch(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v) noexcept
+    {
+        value_or_batch_impl::value_or_batch<T, 1 + sizeof...(Columns)>(
+            default_value, { &to_test_0, &to_test_v... }, out, {}, {});
+    }
+
+    /**
+     * Version of value_or_batch that writes also, in the same pass, the index of
+     * the column that supplied each value: winners[i] is the index of the first
+     * column with a value at the row i, value_or_default_index if no column has
+     * a value.
+     * All the columns and winners must have at least out.size() rows.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param out Coalesced column
+     * \param winners Index of the column used for each row
+     * \param to_test_0 First column to check
+     * \param ...to_test_v Next columns to check
+     * \throw std::invalid_argument if winners has less rows than out
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    constexpr void arg_value_or_batch(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        std::span<std::uint8_t> winners,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        if (winners.size() < out.size())
+            throw std::invalid_argument("arg_value_or_batch: winners has less rows than out");
+        value_or_batch_impl::value_or_batch<T, 1 + sizeof...(Columns)>(
+            default_value, { &to_test_0, &to_test_v... }, out, winners, {});
+    }
+
+    /**
+     * Version of arg_value_or_batch that counts also the rows won by each column:
+     * hits[k] is incremented by the number of rows supplied by the column k,
+     * hits[number of columns] by the number of rows that use the default value.
+     * winners can be empty if only the counts are needed.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param out Coalesced column
+     * \param winners Index of the column used for each row, or an empty span
+     * \param hits Counters of the rows won by each column, number of columns + 1 elements
+     * \param to_test_0 First column to check
+     * \param ...to_test_v Next columns to check
+     * \throw std::invalid_argument if winners is not empty and has less rows than out,
+     *        or hits has not number of columns + 1 elements
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    constexpr void arg_value_or_batch(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        std::span<std::uint8_t> winners, std::span<std::size_t> hits,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        if (hits.empty())
+            throw std::invalid_argument("arg_value_or_batch: hits must have number of columns + 1 elements");
+        value_or_batch_impl::check_outputs<1 + sizeof...(Columns)>(out.size(), winners, hits);
+        value_or_batch_impl::value_or_batch<T, 1 + sizeof...(Columns)>(
+            default_value, { &to_test_0, &to_test_v... }, out, winners, hits);
+    }
+
+    /**
+     * It reduces with op the coalesced column of value_or_batch, without
+     * writing it: the columns are coalesced and reduced in one pass.
+     * op must be associative and commutative. For integers the result is the
+     * same of the scalar loop, for floating points the rounding can differ
+     * because the rows are added in a different order.
+     * All the columns must have the same number of rows.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param init Initial value of the reduction
+     * \param op Binary operation, T op(T, T)
+     * \param to_test_0 First column to check
+     * \param ...to_test_v Next columns to check
+     * \return op(...op(op(init, row_0), row_1)..., row_n), in any order of the rows
+     */
+    template<typename T, typename Op, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+        && std::convertible_to<std::invoke_result_t<Op&, T, T>, T>
+    [[nodiscard]] constexpr T value_or_reduce(const std::type_identity_t<T>& default_value,
+        std::type_identity_t<T> init, Op op,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        return value_or_batch_impl::value_or_reduce<T, 1 + sizeof...(Columns)>(
+            default_value, { &to_test_0, &to_test_v... }, init, op);
+    }
+
+    /**
+     * Sum of the coalesced column: std::accumulate(rows, 0, value_or(default_value, columns...))
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] constexpr T value_or_sum(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        return value_or_reduce(default_value, T{}, std::plus<T>{}, to_test_0, to_test_v...);
+    }
+
+    /**
+     * Minimum of the coalesced column, std::nullopt if the columns are empty.
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] constexpr std::optional<T> value_or_min(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        if (to_test_0.values.empty())
+            return std::nullopt;
+        return value_or_reduce(default_value, std::numeric_limits<T>::max(),
+            [](T a, T b) { return b < a ? b : a; }, to_test_0, to_test_v...);
+    }
+
+    /**
+     * Maximum of the coalesced column, std::nullopt if the columns are empty.
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] constexpr std::optional<T> value_or_max(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        if (to_test_0.values.empty())
+            return std::nullopt;
+        return value_or_reduce(default_value, std::numeric_limits<T>::lowest(),
+            [](T a, T b) { return a < b ? b : a; }, to_test_0, to_test_v...);
+    }
+
+    /**
+     * Mean of the coalesced column, std::nullopt if the columns are empty.
+     * The rows are added as double.
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] constexpr std::optional<double> value_or_mean(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        const std::size_t rows = to_test_0.values.size();
+        if (rows == 0)
+            return std::nullopt;
+
+        double sum = 0;
+        T acc[value_or_batch_impl::block_rows];
+        const std::array<const nullable_column<T>*, 1 + sizeof...(Columns)> columns{ &to_test_0, &to_test_v... };
+        std::plus<double> op;
+        for (std::size_t begin = 0; begin < rows; begin += value_or_batch_impl::block_rows)
+        {
+            const std::size_t block = std::min(value_or_batch_impl::block_rows, rows - begin);
+            value_or_batch_impl::resolve_block<false>(T{ default_value }, columns, begin, block, acc, nullptr);
+            double as_double[value_or_batch_impl::block_rows];
+            for (std::size_t i = 0; i < block; ++i)
+                as_double[i] = static_cast<double>(acc[i]);
+            sum = value_or_batch_impl::reduce_block(as_double, block, sum, op);
+        }
+        return sum / static_cast<double>(rows);
+    }
+
+    /**
+     * It counts the rows where no column has a value, the rows that
+     * value_or_batch resolves with the default value.
+     */
+    template<typename T, typename... Columns>
+    requires (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] constexpr std::size_t value_or_count_default(const nullable_column<T>& to_test_0,
+        const Columns&... to_test_v) noexcept
+    {
+        return value_or_batch_impl::count_default<T, 1 + sizeof...(Columns)>({ &to_test_0, &to_test_v... });
+    }
+
+} // end namespace s4
+
+#endif
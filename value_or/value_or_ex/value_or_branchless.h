@@ -0,0 +1,118 @@
+/**********************************************************************
+ * \file   value_or_branchless.h
+ * \brief  It contains the function:
+ *         value_or_branchless(default_value, to_test_v...).
+ *         It returns the same value of value_or, but without
+ *         conditional branches: every value to test is checked, the
+ *         address of the result is chosen with a chain of selects,
+ *         from the last value to the first so that the first one
+ *         not null wins, and the result is loaded once at the end.
+ *         It is faster than value_or when the null values are not
+ *         predictable, because there is no branch to mispredict.
+ *         The values to test can be raw pointers to T and
+ *         std::optional<T>, with T trivially copyable.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_branchless_H
+#define __value_or_branchless_H
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Concept that defines the values that value_or_branchless can test:
+     * raw pointers to T, that can be null or must point to a valid T, and
+     * std::optional<T>. The test and the address of the value are cheap
+     * and have no side effects.
+     */
+    template<typename ValueHolderType, typename T>
+    concept value_or_branchless_holder = std::is_trivially_copyable_v<T>
+        && (std::same_as<std::remove_cvref_t<ValueHolderType>, T*>
+            || std::same_as<std::remove_cvref_t<ValueHolderType>, const T*>
+            || std::same_as<std::remove_cvref_t<ValueHolderType>, std::optional<T>>);
+
+
+    namespace value_or_branchless_impl
+    {
+        /**
+         * It returns s ? a : b. The selection is done with a mask on the
+         * address, so that the compiler does not turn it in a branch.
+         */
+        template<typename T>
+        [[nodiscard]] inline const T* select(bool s, const T* a, const T* b) noexcept
+        {
+            const std::uintptr_t m = std::uintptr_t{ 0 } - static_cast<std::uintptr_t>(s);
+            return std::bit_cast<const T*>(static_cast<std::uintptr_t>(
+                (std::bit_cast<std::uintptr_t>(a) & m) | (std::bit_cast<std::uintptr_t>(b) & ~m)));
+        }
+
+        /**
+         * It returns p if it is not null, else next.
+         */
+        template<typename T>
+        [[nodiscard]] inline const T* first(const T* p, const T* next) noexcept
+        {
+            return select(p != nullptr, p, next);
+        }
+
+        /**
+         * It returns the address of the value of o if o has a value, else
+         * next. The address of the value is taken only if o has a value, so
+         * the checks of operator* in the debug builds pass; the conditional
+         * expression compiles to a conditional move, and the mask of select
+         * keeps the compiler from turning the chain in an early exit.
+         */
+        template<typename T>
+        [[nodiscard]] inline const T* first(const std::optional<T>& o, const T* next) noexcept
+        {
+            const bool s = o.has_value();
+            return select(s, s ? std::addressof(*o) : next, next);
+        }
+
+        template<typename T>
+        [[nodiscard]] inline const T* value_or(const T* result) noexcept
+        {
+            return result;
+        }
+
+        /**
+         * The values to test are applied in reverse order: the selects of the
+         * last values are overwritten by the ones of the first values.
+         */
+        template<typename T, typename PT, typename... Args>
+        [[nodiscard]] inline const T* value_or(const T* result, const PT& to_test_0, const Args&... to_test_v) noexcept
+        {
+            return first(to_test_0, value_or(result, to_test_v...));
+        }
+    }
+
+
+    /**
+     * Branchless version of value_or: it returns the first element of to_test_v
+     * not null, default_value if all of them are null. All the elements are
+     * tested, and the value is loaded only once.
+     *
+     * \param default_value The value returned if all the elements are null
+     * \param ...to_test_v Raw pointers to T or std::optional<T> to check
+     * \return A copy of the first value not null or of default_value
+     */
+    template<typename T, value_or_branchless_holder<T>... Args>
+    [[nodiscard]] inline T value_or_branchless(const T& default_value, const Args&... to_test_v) noexcept
+    {
+        return *value_or_branchless_impl::value_or(std::addressof(default_value), to_test_v...);
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,203 @@
+/**********************************************************************
+ * \file   value_or_cell.h
+ * \brief  It contains the classes versioned<T> and coalesced_cell<T, N>.
+ *         versioned<T> is a value holder, like std::optional, with a
+ *         version counter incremented by every change.
+ *         coalesced_cell caches value_or(default_value, sources...)
+ *         and the index of the winning source, and recomputes them
+ *         only when a source at or above the winning priority has
+ *         changed its version.
+ *         Every change of a versioned increments also a change
+ *         counter shared by all of them: a read of a cell when no
+ *         versioned has changed since its last read costs one load
+ *         of the counter; after a change anywhere, it checks the
+ *         versions of the sources up to the winning one.
+ *         versioned does not synchronize its value: the changes of
+ *         the value must be synchronized with the reads (and with
+ *         the get of the cells that use it) by the caller, the
+ *         versions only tell the cells what to recompute.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_cell_H
+#define __value_or_cell_H
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace cell_impl
+    {
+        /**
+         * Number of changes of all the versioned, in its own cache line.
+         */
+        struct alignas(64) change_counter
+        {
+            std::atomic<std::uint64_t> changes{ 0 };
+        };
+
+        inline change_counter all_changes;
+    }
+
+    /**
+     * Value holder with a version: every set and reset increments the version.
+     * It has the operators ! and *, so it can be passed to value_or.
+     * The version is atomic, so that it can be checked cheaply, but the value
+     * is not: the changes of the value must be synchronized with the reads
+     * by the caller.
+     */
+    template<typename T>
+    class versioned
+    {
+    public:
+        versioned() = default;
+
+        explicit versioned(T value)
+            : _value{ std::move(value) }
+        {}
+
+        versioned(const versioned&) = delete;
+        versioned& operator=(const versioned&) = delete;
+
+        void set(T value)
+        {
+            _value = std::move(value);
+            changed();
+        }
+
+        void reset() noexcept
+        {
+            _value.reset();
+            changed();
+        }
+
+        [[nodiscard]] std::uint64_t version() const noexcept
+        {
+            return _version.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool operator!() const noexcept
+        {
+            return !_value;
+        }
+
+        [[nodiscard]] const T& operator*() const noexcept
+        {
+            return *_value;
+        }
+
+    private:
+        // the version is incremented before the shared counter: a cell that
+        // sees the new counter sees also the new version
+        void changed() noexcept
+        {
+            _version.fetch_add(1, std::memory_order_release);
+            cell_impl::all_changes.changes.fetch_add(1, std::memory_order_release);
+        }
+
+        std::optional<T> _value;
+        std::atomic<std::uint64_t> _version{ 0 };
+    };
+
+
+    /**
+     * Memoized value_or(default_value, sources...): the value and the index of
+     * the winning source are cached together with the versions of the sources
+     * up to the winning one. The sources after the winner can change without
+     * invalidating the cell, because they cannot change the result.
+     * The sources must live longer than the cell.
+     */
+    template<typename T, std::size_t N>
+    class coalesced_cell
+    {
+    public:
+        /**
+         * \param default_value Value to use when no source has a value
+         * \param ...sources Sources, in priority order
+         */
+        template<typename... Sources>
+        requires (sizeof...(Sources) == N) && (std::same_as<Sources, T> && ...)
+        explicit coalesced_cell(T default_value, const versioned<Sources>&... sources)
+            : _default{ std::move(default_value) }, _sources{ &sources... }
+        {
+            _changes = cell_impl::all_changes.changes.load(std::memory_order_acquire);
+            refresh();
+        }
+
+        /**
+         * It returns value_or(default_value, sources...), it recomputes it
+         * only if a source up to the winning one has changed. If no versioned
+         * has changed since the last get, it costs one load.
+         */
+        [[nodiscard]] const T& get()
+        {
+            const std::uint64_t changes = cell_impl::all_changes.changes.load(std::memory_order_acquire);
+            if (changes == _changes)
+                return _value;
+
+            _changes = changes;
+            for (std::size_t k = 0; k < _checked; ++k)
+            {
+                if (_sources[k]->version() != _versions[k])
+                    return refresh();
+            }
+            return _value;
+        }
+
+        /**
+         * It returns the index of the source used by the last get(),
+         * N if it used the default value.
+         */
+        [[nodiscard]] std::size_t winner() const noexcept
+        {
+            return _winner;
+        }
+
+    private:
+        const T& refresh()
+        {
+            for (std::size_t k = 0; k < N; ++k)
+            {
+                // the version is read before the value: a change after this
+                // point is seen by the next get()
+                _versions[k] = _sources[k]->version();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (!!*_sources[k])
+                {
+                    _value = **_sources[k];
+                    _checked = k + 1;
+                    _winner = k;
+                    return _value;
+                }
+            }
+            _value = _default;
+            _checked = N;
+            _winner = N;
+            return _value;
+        }
+
+        T _default;
+        T _value{};
+        std::uint64_t _changes = 0;
+        std::size_t _checked = 0;
+        std::size_t _winner = N;
+        std::array<const versioned<T>*, N> _sources;
+        std::array<std::uint64_t, N> _versions{};
+    };
+
+    template<typename T, typename... Sources>
+    coalesced_cell(T, const versioned<Sources>&...) -> coalesced_cell<T, sizeof...(Sources)>;
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,266 @@
+/**********************************************************************
+ * \file   value_or_chain.h
+ * \brief  It contains the class coalesce_chain<T, N>: a list of at
+ *         most N sources built at runtime (for example by plugins),
+ *         and value_or(default_value) that returns the value of the
+ *         first source that has it.
+ *         A source can be a value holder (a raw pointer, a
+ *         std::optional, ...), an invocable that returns a value
+ *         holder, or a value of type T, that always has a value.
+ *         The sources are stored inline, without heap allocations,
+ *         and each test is one indirect call.
+ *         freeze() drops the sources after the first value of type T,
+ *         that are never used, and copies the sources in an array
+ *         tagged with their kind: the raw pointers, the
+ *         std::optional<T> and the values of type T are tested
+ *         inline, without indirect calls; the invocables and the
+ *         other value holders keep one indirect call each, their
+ *         type is known only to the function stored by push_back.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_chain_H
+#define __value_or_chain_H
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace chain_impl
+    {
+        /**
+         * It tests the source stored in storage: if it has a value it writes
+         * it in out and returns true.
+         */
+        template<typename T>
+        using probe_fn = bool (*)(const void* storage, std::optional<T>& out);
+
+        template<typename T, typename S>
+        bool probe(const void* storage, std::optional<T>& out)
+        {
+            const S& source = *std::launder(static_cast<const S*>(storage));
+            if constexpr (std::same_as<S, T>)
+            {
+                out.emplace(source);
+                return true;
+            }
+            else if constexpr (std::invocable<const S&>)
+            {
+                auto&& value_holder = source();
+                if (!value_holder)
+                    return false;
+                out.emplace(*value_holder);
+                return true;
+            }
+            else
+            {
+                if (!source)
+                    return false;
+                out.emplace(*source);
+                return true;
+            }
+        }
+
+        /**
+         * Type stored for a source of type S: the pointers to T are stored as
+         * const T*, so that freeze() can recognize them.
+         */
+        template<typename T, typename S>
+        using stored_t = std::conditional_t<std::is_convertible_v<S, const T*> && std::is_pointer_v<S>, const T*, S>;
+
+        /**
+         * Kind of a stored source: freeze() tests inline all the kinds but call.
+         */
+        enum class source_kind : std::uint8_t
+        {
+            pointer,
+            optional,
+            constant,
+            call,
+        };
+
+        template<typename T, typename S>
+        inline constexpr source_kind kind_of = std::is_same_v<S, const T*> ? source_kind::pointer
+            : std::is_same_v<S, std::optional<T>> ? source_kind::optional
+            : std::is_same_v<S, T> ? source_kind::constant
+            : source_kind::call;
+    }
+
+
+    /**
+     * Concept that defines a source of coalesce_chain<T>: a T, a value holder of
+     * T or an invocable that returns it. It is stored by copy, so it must be
+     * trivially copyable and it must fit in StorageSize bytes.
+     */
+    template<typename S, typename T, std::size_t StorageSize>
+    concept coalesce_chain_source = std::is_trivially_copyable_v<S>
+        && sizeof(S) <= StorageSize
+        && alignof(S) <= alignof(std::max_align_t)
+        && (std::same_as<S, T>
+            || requires(const S& value_holder, const T& value)
+            {
+                {!value_holder ? value : *value_holder} -> std::convertible_to<T>;
+            }
+            || requires(const S& callable, const T& value)
+            {
+                {!callable() ? value : *callable()} -> std::convertible_to<T>;
+            });
+
+
+    /**
+     * Chain of at most N sources of values of type T, evaluated in the order
+     * they have been added.
+     */
+    template<typename T, std::size_t N, std::size_t StorageSize = 2 * sizeof(void*)>
+    class coalesce_chain
+    {
+    public:
+        /**
+         * It adds source at the end of the chain. After freeze() the chain is
+         * unfrozen.
+         *
+         * \throw std::length_error if the chain has already N sources
+         */
+        template<coalesce_chain_source<T, StorageSize> S>
+        void push_back(const S& source)
+        {
+            using stored = chain_impl::stored_t<T, S>;
+            if (_size == N)
+                throw std::length_error("coalesce_chain: too many sources");
+
+            entry& e = _entries[_size];
+            ::new (static_cast<void*>(e.storage)) stored(source);
+            e.probe = &chain_impl::probe<T, stored>;
+            e.kind = chain_impl::kind_of<T, stored>;
+            ++_size;
+            _frozen = false;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return _size;
+        }
+
+        [[nodiscard]] static constexpr std::size_t capacity() noexcept
+        {
+            return N;
+        }
+
+        [[nodiscard]] bool frozen() const noexcept
+        {
+            return _frozen;
+        }
+
+        /**
+         * It prepares the chain for the evaluations: the sources after the
+         * first T are dropped, and the others are copied in an array with
+         * their kind, where the pointers, the optionals and the T are tested
+         * without indirect calls.
+         */
+        void freeze() noexcept
+        {
+            for (std::size_t i = 0; i < _size; ++i)
+            {
+                if (_entries[i].kind == chain_impl::source_kind::constant)
+                {
+                    _size = i + 1;
+                    break;
+                }
+            }
+
+            for (std::size_t i = 0; i < _size; ++i)
+            {
+                const entry& e = _entries[i];
+                frozen_entry& f = _frozen_entries[i];
+                f.kind = e.kind;
+                f.index = i;
+                f.pointer = e.kind == chain_impl::source_kind::pointer
+                    ? *std::launder(reinterpret_cast<const T* const*>(e.storage))
+                    : nullptr;
+            }
+            _frozen = true;
+        }
+
+        /**
+         * It returns the value of the first source that has it, default_value
+         * if no source has it.
+         */
+        [[nodiscard]] T value_or(const T& default_value) const
+        {
+            std::optional<T> r;
+            if (_frozen)
+            {
+                for (std::size_t i = 0; i < _size; ++i)
+                {
+                    const frozen_entry& f = _frozen_entries[i];
+                    const entry& e = _entries[f.index];
+                    switch (f.kind)
+                    {
+                    case chain_impl::source_kind::pointer:
+                        if (f.pointer != nullptr)
+                            return *f.pointer;
+                        break;
+                    case chain_impl::source_kind::optional:
+                    {
+                        const std::optional<T>& o = *std::launder(reinterpret_cast<const std::optional<T>*>(e.storage));
+                        if (o.has_value())
+                            return *o;
+                        break;
+                    }
+                    case chain_impl::source_kind::constant:
+                        return *std::launder(reinterpret_cast<const T*>(e.storage));
+                    case chain_impl::source_kind::call:
+                        if (e.probe(e.storage, r))
+                            return std::move(*r);
+                        break;
+                    }
+                }
+                return default_value;
+            }
+
+            for (std::size_t i = 0; i < _size; ++i)
+            {
+                if (_entries[i].probe(_entries[i].storage, r))
+                    return std::move(*r);
+            }
+            return default_value;
+        }
+
+    private:
+        struct entry
+        {
+            chain_impl::probe_fn<T> probe = nullptr;
+            chain_impl::source_kind kind = chain_impl::source_kind::call;
+            alignas(std::max_align_t) std::byte storage[StorageSize];
+        };
+
+        // the pointers are copied, the other sources are read from their entry
+        // by index, so a copy of a frozen chain reads its own entries
+        struct frozen_entry
+        {
+            chain_impl::source_kind kind = chain_impl::source_kind::call;
+            std::size_t index = 0;
+            const T* pointer = nullptr;
+        };
+
+        std::array<entry, N> _entries{};
+        std::array<frozen_entry, N> _frozen_entries{};
+        std::size_t _size = 0;
+        bool _frozen = false;
+    };
+
+} // end namespace s4
+
+#endif
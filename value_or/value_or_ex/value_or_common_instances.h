@@ -0,0 +1,43 @@
+/**********************************************************************
+ * \file   value_or_common_instances.h
+ * \brief  It contains the list S4_VALUE_OR_COMMON_INSTANCES of the
+ *         common instances of value_or_canonical, and declares them
+ *         extern: the translation units that include this header
+ *         call the instances, they do not generate them.
+ *         The instances are defined in one translation unit,
+ *         value_or_codegen/common_instances.cpp, that must be linked
+ *         with the program. The list is written by hand: the
+ *         signatures of the value holders in canonical form (without
+ *         const and references, const T* for the pointers), see
+ *         value_or_instance.h; value_or_codegen/size_report.sh prints
+ *         the size of each one.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_common_instances_H
+#define __value_or_common_instances_H
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "value_or_instance.h"
+
+
+#define S4_VALUE_OR_COMMON_INSTANCES(X)                                     \
+    X(int, const int*)                                                      \
+    X(int, const int*, const int*)                                          \
+    X(int, std::optional<int>)                                              \
+    X(int, std::optional<int>, std::optional<int>)                          \
+    X(int, const int*, std::unique_ptr<int>)                                \
+    X(int, std::shared_ptr<int>, std::optional<int>)                        \
+    X(double, std::optional<double>, const double*)                         \
+    X(std::string, const std::string*)                                      \
+    X(std::string, std::optional<std::string>, std::optional<std::string>)  \
+    X(std::string, std::shared_ptr<std::string>, const std::string*)
+
+S4_VALUE_OR_COMMON_INSTANCES(S4_VALUE_OR_EXTERN)
+
+#endif
@@ -0,0 +1,448 @@
+/**********************************************************************
+ * \file   value_or_dispatch.h
+ * \brief  It contains the versions of the batch kernels that choose
+ *         the instruction set at runtime, for a binary that runs on
+ *         x86 processors of different generations:
+ *         value_or_batch_dispatched, arg_value_or_batch_dispatched,
+ *         value_or_batch_projected_dispatched,
+ *         value_or_adaptive_dispatched, value_or_sum_dispatched,
+ *         value_or_min_dispatched, value_or_max_dispatched,
+ *         value_or_mean_dispatched and
+ *         value_or_count_default_dispatched have the parameters of the
+ *         functions without _dispatched; run_dispatched(rule, ...)
+ *         is coalesce_rule::run.
+ *         Each kernel is compiled for the target of the build
+ *         (scalar), and with GCC and Clang on x86 also for SSE4.2,
+ *         AVX2 and AVX-512 (F and BW): the kernel is inlined in a
+ *         function with the target attribute, so the compiler
+ *         vectorizes its loops for that instruction set. With GCC
+ *         the versions have also the optimize attribute with
+ *         tree-vectorize and the dynamic cost model, so they are
+ *         vectorized also when the program is built at -O2.
+ *         The first call of a kernel takes the version for
+ *         value_or_active_isa(), the best instruction set supported
+ *         by the processor, read once with cpuid.
+ *         The environment variable S4_VALUE_OR_ISA (scalar, sse4.2,
+ *         avx2, avx512) forces a lower instruction set, for tests and
+ *         benchmarks; it cannot select an instruction set that the
+ *         processor does not support.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_dispatch_H
+#define __value_or_dispatch_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "value_or_adaptive.h"
+#include "value_or_batch.h"
+#include "value_or_project.h"
+#include "value_or_rules.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define S4_VALUE_OR_DISPATCH_X86
+#endif
+
+// GCC vectorizes the versions also at -O2, Clang vectorizes at -O2 by default
+#if defined(__GNUC__) && !defined(__clang__)
+#define S4_VALUE_OR_DISPATCH_VECTORIZE [[gnu::optimize("tree-vectorize", "vect-cost-model=dynamic")]]
+#else
+#define S4_VALUE_OR_DISPATCH_VECTORIZE
+#endif
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Instruction sets of the versions of the kernels, in increasing order.
+     */
+    enum class value_or_isa : std::uint8_t
+    {
+        scalar,
+        sse4_2,
+        avx2,
+        avx512,
+    };
+
+    [[nodiscard]] constexpr std::string_view to_string(value_or_isa isa) noexcept
+    {
+        switch (isa)
+        {
+        case value_or_isa::scalar: return "scalar";
+        case value_or_isa::sse4_2: return "sse4.2";
+        case value_or_isa::avx2: return "avx2";
+        case value_or_isa::avx512: return "avx512";
+        }
+        return "unknown";
+    }
+
+
+    namespace dispatch_impl
+    {
+        /**
+         * It returns the instruction set to use: the value of S4_VALUE_OR_ISA
+         * if it is valid and not greater than detected, else detected.
+         */
+        [[nodiscard]] constexpr value_or_isa isa_from_environment(const char* value, value_or_isa detected) noexcept
+        {
+            if (value == nullptr)
+                return detected;
+            for (value_or_isa isa : { value_or_isa::scalar, value_or_isa::sse4_2, value_or_isa::avx2, value_or_isa::avx512 })
+            {
+                if (to_string(isa) == value)
+                    return std::min(isa, detected);
+            }
+            return detected;
+        }
+
+        /**
+         * Versions of Kernel: Kernel{}(args...) inlined in functions compiled
+         * for each instruction set. flatten inlines also the functions called
+         * by the kernel, that otherwise would be compiled for the build target.
+         */
+        template<typename Kernel, typename R, typename... Args>
+        struct versions
+        {
+            using function = R (*)(Args...);
+
+#ifdef S4_VALUE_OR_DISPATCH_X86
+            S4_VALUE_OR_DISPATCH_VECTORIZE [[gnu::flatten]] static R scalar(Args... args)
+            {
+                return Kernel{}(args...);
+            }
+
+            S4_VALUE_OR_DISPATCH_VECTORIZE [[gnu::target("sse4.2"), gnu::flatten]] static R sse4_2(Args... args)
+            {
+                return Kernel{}(args...);
+            }
+
+            S4_VALUE_OR_DISPATCH_VECTORIZE [[gnu::target("avx2"), gnu::flatten]] static R avx2(Args... args)
+            {
+                return Kernel{}(args...);
+            }
+
+            S4_VALUE_OR_DISPATCH_VECTORIZE [[gnu::target("avx512f,avx512bw"), gnu::flatten]] static R avx512(Args... args)
+            {
+                return Kernel{}(args...);
+            }
+#else
+            static R scalar(Args... args)
+            {
+                return Kernel{}(args...);
+            }
+#endif
+
+            [[nodiscard]] static function select(value_or_isa isa) noexcept
+            {
+#ifdef S4_VALUE_OR_DISPATCH_X86
+                switch (isa)
+                {
+                case value_or_isa::avx512: return &avx512;
+                case value_or_isa::avx2: return &avx2;
+                case value_or_isa::sse4_2: return &sse4_2;
+                case value_or_isa::scalar: break;
+                }
+#else
+                (void)isa;
+#endif
+                return &scalar;
+            }
+        };
+    }
+
+
+    /**
+     * It returns the best instruction set supported by the processor.
+     */
+    [[nodiscard]] inline value_or_isa value_or_detected_isa() noexcept
+    {
+#ifdef S4_VALUE_OR_DISPATCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+            return value_or_isa::avx512;
+        if (__builtin_cpu_supports("avx2"))
+            return value_or_isa::avx2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return value_or_isa::sse4_2;
+#endif
+        return value_or_isa::scalar;
+    }
+
+    /**
+     * It returns the instruction set used by the dispatched kernels: the
+     * detected one, or the one of S4_VALUE_OR_ISA if it is lower. It is read
+     * at the first call.
+     */
+    [[nodiscard]] inline value_or_isa value_or_active_isa() noexcept
+    {
+        static const value_or_isa isa = dispatch_impl::isa_from_environment(std::getenv("S4_VALUE_OR_ISA"),
+            value_or_detected_isa());
+        return isa;
+    }
+
+
+    namespace dispatch_impl
+    {
+        /**
+         * It calls the version of Kernel for value_or_active_isa(), chosen at
+         * the first call.
+         */
+        template<typename Kernel, typename R, typename... Args>
+        R dispatch(Args... args)
+        {
+            static const auto function = versions<Kernel, R, Args...>::select(value_or_active_isa());
+            return function(args...);
+        }
+
+        template<typename T, std::size_t N>
+        struct batch_kernel
+        {
+            void operator()(const T& default_value, const std::array<const nullable_column<T>*, N>& columns,
+                std::span<T> out, std::span<std::uint8_t> winners, std::span<std::size_t> hits) const noexcept
+            {
+                value_or_batch_impl::value_or_batch<T, N>(default_value, columns, out, winners, hits);
+            }
+        };
+
+        template<typename T, std::size_t N>
+        struct adaptive_batch_kernel
+        {
+            void operator()(const T& default_value, const std::array<const nullable_column<T>*, N>& columns,
+                std::span<T> out, std::span<s4::adaptive_kernel> choices) const noexcept
+            {
+                adaptive_impl::value_or_adaptive<T, N>(default_value, columns, out, choices);
+            }
+        };
+
+        struct projected_kernel
+        {
+            template<typename T, typename... Sources>
+            void operator()(const T& default_value, std::span<T> out, const Sources&... sources) const
+            {
+                value_or_batch_projected(default_value, out, sources...);
+            }
+        };
+
+        struct sum_kernel
+        {
+            template<typename T, typename... Columns>
+            T operator()(const T& default_value, const nullable_column<T>& to_test_0, const Columns&... to_test_v) const
+            {
+                return value_or_sum<T>(default_value, to_test_0, to_test_v...);
+            }
+        };
+
+        struct min_kernel
+        {
+            template<typename T, typename... Columns>
+            std::optional<T> operator()(const T& default_value, const nullable_column<T>& to_test_0,
+                const Columns&... to_test_v) const
+            {
+                return value_or_min<T>(default_value, to_test_0, to_test_v...);
+            }
+        };
+
+        struct max_kernel
+        {
+            template<typename T, typename... Columns>
+            std::optional<T> operator()(const T& default_value, const nullable_column<T>& to_test_0,
+                const Columns&... to_test_v) const
+            {
+                return value_or_max<T>(default_value, to_test_0, to_test_v...);
+            }
+        };
+
+        struct mean_kernel
+        {
+            template<typename T, typename... Columns>
+            std::optional<double> operator()(const T& default_value, const nullable_column<T>& to_test_0,
+                const Columns&... to_test_v) const
+            {
+                return value_or_mean<T>(default_value, to_test_0, to_test_v...);
+            }
+        };
+
+        struct count_default_kernel
+        {
+            template<typename T, typename... Columns>
+            std::size_t operator()(const nullable_column<T>& to_test_0, const Columns&... to_test_v) const noexcept
+            {
+                return value_or_count_default<T>(to_test_0, to_test_v...);
+            }
+        };
+
+        struct rule_kernel
+        {
+            template<typename T>
+            void operator()(const coalesce_rule<T>& rule, const T& default_value, std::span<T> out,
+                std::span<const nullable_column<T>> columns) const
+            {
+                rule.run(default_value, out, columns);
+            }
+        };
+
+        template<typename T, std::size_t N>
+        using batch_columns = const std::array<const nullable_column<T>*, N>&;
+    }
+
+
+    /**
+     * value_or_batch with the kernel for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    void value_or_batch_dispatched(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        constexpr std::size_t N = 1 + sizeof...(Columns);
+        dispatch_impl::dispatch<dispatch_impl::batch_kernel<T, N>, void, const T&, dispatch_impl::batch_columns<T, N>,
+            std::span<T>, std::span<std::uint8_t>, std::span<std::size_t>>(
+            default_value, { &to_test_0, &to_test_v... }, out, {}, {});
+    }
+
+    /**
+     * arg_value_or_batch, with the winners and the hits, with the kernel for
+     * value_or_active_isa(). winners and hits can be empty.
+     *
+     * \throw std::invalid_argument if winners is not empty and has less rows than out,
+     *        or hits is not empty and has not number of columns + 1 elements
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    void arg_value_or_batch_dispatched(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        std::span<std::uint8_t> winners, std::span<std::size_t> hits,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        constexpr std::size_t N = 1 + sizeof...(Columns);
+        value_or_batch_impl::check_outputs<N>(out.size(), winners, hits);
+        dispatch_impl::dispatch<dispatch_impl::batch_kernel<T, N>, void, const T&, dispatch_impl::batch_columns<T, N>,
+            std::span<T>, std::span<std::uint8_t>, std::span<std::size_t>>(
+            default_value, { &to_test_0, &to_test_v... }, out, winners, hits);
+    }
+
+    /**
+     * value_or_batch_projected with the kernel for value_or_active_isa().
+     */
+    template<typename Source, typename... Sources>
+    requires std::is_trivially_copyable_v<typename project_impl::source_traits<Source>::value_type>
+        && (std::same_as<typename project_impl::source_traits<Source>::value_type,
+            typename project_impl::source_traits<Sources>::value_type> && ...)
+    void value_or_batch_projected_dispatched(const typename project_impl::source_traits<Source>::value_type& default_value,
+        std::span<typename project_impl::source_traits<Source>::value_type> out,
+        const Source& source_0, const Sources&... source_v)
+    {
+        using T = typename project_impl::source_traits<Source>::value_type;
+        dispatch_impl::dispatch<dispatch_impl::projected_kernel, void, const T&, std::span<T>,
+            const Source&, const Sources&...>(default_value, out, source_0, source_v...);
+    }
+
+    /**
+     * value_or_adaptive with the kernels for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires std::is_trivially_copyable_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    void value_or_adaptive_dispatched(const std::type_identity_t<T>& default_value, std::span<std::type_identity_t<T>> out,
+        std::span<adaptive_kernel> choices, const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        constexpr std::size_t N = 1 + sizeof...(Columns);
+        dispatch_impl::dispatch<dispatch_impl::adaptive_batch_kernel<T, N>, void, const T&, dispatch_impl::batch_columns<T, N>,
+            std::span<T>, std::span<s4::adaptive_kernel>>(
+            default_value, { &to_test_0, &to_test_v... }, out, choices);
+    }
+
+    /**
+     * value_or_sum with the kernel for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] T value_or_sum_dispatched(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        return dispatch_impl::dispatch<dispatch_impl::sum_kernel, T, const T&, const nullable_column<T>&,
+            const Columns&...>(default_value, to_test_0, to_test_v...);
+    }
+
+    /**
+     * value_or_min with the kernel for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] std::optional<T> value_or_min_dispatched(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        return dispatch_impl::dispatch<dispatch_impl::min_kernel, std::optional<T>, const T&, const nullable_column<T>&,
+            const Columns&...>(default_value, to_test_0, to_test_v...);
+    }
+
+    /**
+     * value_or_max with the kernel for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] std::optional<T> value_or_max_dispatched(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        return dispatch_impl::dispatch<dispatch_impl::max_kernel, std::optional<T>, const T&, const nullable_column<T>&,
+            const Columns&...>(default_value, to_test_0, to_test_v...);
+    }
+
+    /**
+     * value_or_mean with the kernel for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires std::is_arithmetic_v<T>
+        && (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] std::optional<double> value_or_mean_dispatched(const std::type_identity_t<T>& default_value,
+        const nullable_column<T>& to_test_0, const Columns&... to_test_v)
+    {
+        return dispatch_impl::dispatch<dispatch_impl::mean_kernel, std::optional<double>, const T&,
+            const nullable_column<T>&, const Columns&...>(default_value, to_test_0, to_test_v...);
+    }
+
+    /**
+     * value_or_count_default with the kernel for value_or_active_isa().
+     */
+    template<typename T, typename... Columns>
+    requires (std::same_as<Columns, nullable_column<T>> && ...)
+    [[nodiscard]] std::size_t value_or_count_default_dispatched(const nullable_column<T>& to_test_0,
+        const Columns&... to_test_v)
+    {
+        return dispatch_impl::dispatch<dispatch_impl::count_default_kernel, std::size_t, const nullable_column<T>&,
+            const Columns&...>(to_test_0, to_test_v...);
+    }
+
+    /**
+     * rule.run(default_value, out, columns) with the kernel for
+     * value_or_active_isa().
+     *
+     * \throw std::invalid_argument if columns has less columns than the names passed to compile
+     */
+    template<typename T>
+    void run_dispatched(const coalesce_rule<T>& rule, const std::type_identity_t<T>& default_value,
+        std::span<std::type_identity_t<T>> out, std::span<const nullable_column<std::type_identity_t<T>>> columns)
+    {
+        dispatch_impl::dispatch<dispatch_impl::rule_kernel, void, const coalesce_rule<T>&, const T&, std::span<T>,
+            std::span<const nullable_column<T>>>(rule, default_value, out, columns);
+    }
+
+} // end namespace s4
+
+#endif
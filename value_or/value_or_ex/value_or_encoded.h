@@ -0,0 +1,270 @@
+/**********************************************************************
+ * \file   value_or_encoded.h
+ * \brief  It contains the versions of value_or for encoded columns,
+ *         that are not expanded:
+ *         rle_column, a run length encoded column, made of runs of
+ *         rows with the same value or null,
+ *         sparse_column, the indexes and the values of the rows that
+ *         are not null.
+ *         value_or_rle(default_value, columns...) returns the
+ *         coalesced column run length encoded,
+ *         value_or_dense(default_value, out, columns...) writes it
+ *         in out.
+ *         The columns are merged by segments: each step finds the
+ *         value of the first column that has it and the first row
+ *         where a column up to that one changes, so the cost depends
+ *         on the number of runs and of values, not on the rows.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_encoded_H
+#define __value_or_encoded_H
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Run of length rows with the same value, or null.
+     */
+    template<typename T>
+    struct rle_run
+    {
+        std::size_t length = 0;
+        std::optional<T> value;
+
+        bool operator==(const rle_run&) const = default;
+    };
+
+    /**
+     * Run length encoded column: the rows are the sum of the lengths of the runs.
+     */
+    template<typename T>
+    struct rle_column
+    {
+        std::span<const rle_run<T>> runs;
+    };
+
+    /**
+     * Sparse column of rows rows: the row indexes[i] has the value values[i],
+     * the other rows are null. The indexes must be sorted and unique.
+     */
+    template<typename T>
+    struct sparse_column
+    {
+        std::size_t rows = 0;
+        std::span<const std::size_t> indexes;
+        std::span<const T> values;
+    };
+
+
+    namespace encoded_impl
+    {
+        /**
+         * Position in a rle_column: seek(row) moves to the run of row, then
+         * value() is the value of row and end() the first row of the next run.
+         */
+        template<typename T>
+        class cursor_of_rle
+        {
+        public:
+            explicit cursor_of_rle(const rle_column<T>& column) noexcept
+                : _runs{ column.runs }
+            {}
+
+            void seek(std::size_t row) noexcept
+            {
+                while (_run < _runs.size() && _begin + _runs[_run].length <= row)
+                    _begin += _runs[_run++].length;
+            }
+
+            [[nodiscard]] const T* value() const noexcept
+            {
+                return _run < _runs.size() && _runs[_run].value ? &*_runs[_run].value : nullptr;
+            }
+
+            [[nodiscard]] std::size_t end() const noexcept
+            {
+                return _run < _runs.size() ? _begin + _runs[_run].length : static_cast<std::size_t>(-1);
+            }
+
+        private:
+            std::span<const rle_run<T>> _runs;
+            std::size_t _run = 0;
+            std::size_t _begin = 0;
+        };
+
+        /**
+         * Position in a sparse_column: a row with a value is a segment of one row,
+         * the rows between two values are a null segment. seek skips the values
+         * with a binary search.
+         */
+        template<typename T>
+        class cursor_of_sparse
+        {
+        public:
+            explicit cursor_of_sparse(const sparse_column<T>& column) noexcept
+                : _column{ column }
+            {}
+
+            void seek(std::size_t row) noexcept
+            {
+                _row = row;
+                if (_next < _column.indexes.size() && _column.indexes[_next] < row)
+                {
+                    _next = static_cast<std::size_t>(std::lower_bound(_column.indexes.begin() + _next,
+                        _column.indexes.end(), row) - _column.indexes.begin());
+                }
+            }
+
+            [[nodiscard]] const T* value() const noexcept
+            {
+                return _next < _column.indexes.size() && _column.indexes[_next] == _row ? &_column.values[_next] : nullptr;
+            }
+
+            [[nodiscard]] std::size_t end() const noexcept
+            {
+                if (_next == _column.indexes.size())
+                    return _column.rows;
+                return _column.indexes[_next] == _row ? _row + 1 : _column.indexes[_next];
+            }
+
+        private:
+            const sparse_column<T>& _column;
+            std::size_t _next = 0;
+            std::size_t _row = 0;
+        };
+
+        template<typename T>
+        [[nodiscard]] cursor_of_rle<T> cursor(const rle_column<T>& column) noexcept
+        {
+            return cursor_of_rle<T>{ column };
+        }
+
+        template<typename T>
+        [[nodiscard]] cursor_of_sparse<T> cursor(const sparse_column<T>& column) noexcept
+        {
+            return cursor_of_sparse<T>{ column };
+        }
+
+        template<typename T>
+        [[nodiscard]] std::size_t rows(const rle_column<T>& column) noexcept
+        {
+            std::size_t r = 0;
+            for (const rle_run<T>& run : column.runs)
+                r += run.length;
+            return r;
+        }
+
+        template<typename T>
+        [[nodiscard]] std::size_t rows(const sparse_column<T>& column) noexcept
+        {
+            return column.rows;
+        }
+
+        template<typename Column>
+        struct value_type;
+
+        template<typename T>
+        struct value_type<rle_column<T>> { using type = T; };
+
+        template<typename T>
+        struct value_type<sparse_column<T>> { using type = T; };
+
+        /**
+         * It calls f(begin, end, value) for every segment of the coalesced column,
+         * value is nullptr for the segments where no column has a value.
+         * A segment ends at the first row where one of the columns up to the
+         * winning one changes; the columns after it are not moved.
+         */
+        template<typename T, typename F, typename... Columns>
+        void for_each_segment(F&& f, const Columns&... columns)
+        {
+            const std::size_t row_count = std::min({ rows(columns)... });
+            if (((rows(columns) != row_count) || ...))
+                throw std::invalid_argument("value_or_encoded: the columns have different rows");
+
+            auto cursors = std::make_tuple(cursor(columns)...);
+            for (std::size_t begin = 0; begin < row_count; )
+            {
+                std::size_t end = row_count;
+                const T* value = nullptr;
+                std::apply([&](auto&... c)
+                {
+                    (void)((c.seek(begin), end = std::min(end, c.end()), (value = c.value()) != nullptr) || ...);
+                }, cursors);
+
+                f(begin, end, value);
+                begin = end;
+            }
+        }
+    }
+
+
+    /**
+     * Run length encoded value_or: it returns the coalesced column, where the
+     * rows without a value in all the columns have default_value. The adjacent
+     * runs with the same value are merged.
+     * All the columns must have the same rows.
+     *
+     * \param default_value Value of the rows where no column has a value
+     * \param column_0 First column to check, a rle_column or a sparse_column
+     * \param ...column_v Next columns to check
+     * \return The runs of the coalesced column, all with a value
+     * \throw std::invalid_argument if the columns have different rows
+     */
+    template<typename Column, typename... Columns>
+    [[nodiscard]] auto value_or_rle(const typename encoded_impl::value_type<Column>::type& default_value,
+        const Column& column_0, const Columns&... column_v)
+    {
+        using T = typename encoded_impl::value_type<Column>::type;
+        std::vector<rle_run<T>> r;
+        encoded_impl::for_each_segment<T>([&](std::size_t begin, std::size_t end, const T* value)
+        {
+            const T& v = value != nullptr ? *value : default_value;
+            if (!r.empty() && *r.back().value == v)
+                r.back().length += end - begin;
+            else
+                r.push_back({ end - begin, v });
+        }, column_0, column_v...);
+        return r;
+    }
+
+    /**
+     * Dense value_or: it writes the coalesced column in out, that must have
+     * the same rows of the columns.
+     *
+     * \param default_value Value of the rows where no column has a value
+     * \param out Coalesced column
+     * \param column_0 First column to check, a rle_column or a sparse_column
+     * \param ...column_v Next columns to check
+     * \throw std::invalid_argument if the columns or out have different rows
+     */
+    template<typename Column, typename... Columns>
+    void value_or_dense(const typename encoded_impl::value_type<Column>::type& default_value,
+        std::span<typename encoded_impl::value_type<Column>::type> out,
+        const Column& column_0, const Columns&... column_v)
+    {
+        using T = typename encoded_impl::value_type<Column>::type;
+        if (out.size() != encoded_impl::rows(column_0))
+            throw std::invalid_argument("value_or_encoded: out has different rows");
+
+        encoded_impl::for_each_segment<T>([&](std::size_t begin, std::size_t end, const T* value)
+        {
+            std::fill(out.begin() + begin, out.begin() + end, value != nullptr ? *value : default_value);
+        }, column_0, column_v...);
+    }
+
+} // end namespace s4
+
+#endif
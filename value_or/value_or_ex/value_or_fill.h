@@ -0,0 +1,271 @@
+/**********************************************************************
+ * \file   value_or_fill.h
+ * \brief  It contains the functions ffill and bfill: the forward fill
+ *         (last observation carried forward) and the backward fill of
+ *         a column, in place. Each null row becomes
+ *         value_or(previous resolved row, row), or the next one for
+ *         bfill. The columns can be spans of std::optional, values
+ *         with a validity bitmap, or floating points where the null
+ *         is NaN. max_gap limits how far a value is carried.
+ *         The rows are processed in blocks: the index of the last
+ *         valid row is computed with a prefix max over the block,
+ *         that the compiler vectorizes, and carried to the next block.
+ *         With more threads the column is split in partitions: the
+ *         first pass finds the last valid row of each partition, the
+ *         second pass fills each partition with its carry.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_fill_H
+#define __value_or_fill_H
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * max_gap value for no limit: every null row after a valid row is filled.
+     */
+    inline constexpr std::size_t fill_no_limit = static_cast<std::size_t>(-1);
+
+
+    namespace fill_impl
+    {
+        // rows of a block, the partitions of the threads are multiple of it
+        inline constexpr std::size_t block_rows = 256;
+
+        inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        template<typename T>
+        struct optional_column
+        {
+            std::span<std::optional<T>> values;
+
+            std::size_t size() const noexcept { return values.size(); }
+            bool valid(std::size_t i) const noexcept { return values[i].has_value(); }
+            void copy(std::size_t to, std::size_t from) { values[to] = *values[from]; }
+        };
+
+        template<typename T>
+        struct bitmap_column
+        {
+            std::span<T> values;
+            std::span<std::uint64_t> valid_bits;
+
+            std::size_t size() const noexcept { return values.size(); }
+
+            bool valid(std::size_t i) const noexcept
+            {
+                return (valid_bits[i / 64] >> (i % 64)) & 1;
+            }
+
+            void copy(std::size_t to, std::size_t from)
+            {
+                values[to] = values[from];
+                valid_bits[to / 64] |= std::uint64_t{ 1 } << (to % 64);
+            }
+        };
+
+        template<std::floating_point T>
+        struct nan_column
+        {
+            std::span<T> values;
+
+            std::size_t size() const noexcept { return values.size(); }
+            bool valid(std::size_t i) const noexcept { return !std::isnan(values[i]); }
+            void copy(std::size_t to, std::size_t from) noexcept { values[to] = values[from]; }
+        };
+
+        /**
+         * Column seen in the order of the fill: the row i of a backward
+         * fill is the row size() - 1 - i of the column.
+         */
+        template<typename Column, bool Backward>
+        struct ordered
+        {
+            Column& column;
+
+            std::size_t size() const noexcept { return column.size(); }
+            std::size_t row(std::size_t i) const noexcept { return Backward ? column.size() - 1 - i : i; }
+            bool valid(std::size_t i) const noexcept { return column.valid(row(i)); }
+            void copy(std::size_t to, std::size_t from) { column.copy(row(to), row(from)); }
+        };
+
+        /**
+         * It fills the rows [begin, end), carry is the last valid row before
+         * begin (npos if there is none).
+         * In each block, last[i] is the index, in the block, of the last valid
+         * row up to i, -1 if there is none. It is computed with a Hillis-Steele
+         * prefix max: log2(block_rows) vectorizable passes of 16 bit integers.
+         */
+        template<typename Column>
+        void fill_range(Column column, std::size_t begin, std::size_t end, std::size_t carry, std::size_t max_gap)
+        {
+            std::int16_t last[block_rows];
+            std::int16_t tmp[block_rows];
+
+            for (std::size_t b = begin; b < end; b += block_rows)
+            {
+                const std::size_t rows = std::min(block_rows, end - b);
+                for (std::size_t i = 0; i < rows; ++i)
+                    last[i] = column.valid(b + i) ? static_cast<std::int16_t>(i) : std::int16_t{ -1 };
+                for (std::size_t i = rows; i < block_rows; ++i)
+                    last[i] = -1;
+
+                for (std::size_t step = 1; step < block_rows; step *= 2)
+                {
+                    std::copy_n(last, block_rows, tmp);
+                    for (std::size_t i = step; i < block_rows; ++i)
+                        last[i] = std::max(tmp[i], tmp[i - step]);
+                }
+
+                for (std::size_t i = 0; i < rows; ++i)
+                {
+                    const std::size_t from = last[i] < 0 ? carry : b + static_cast<std::size_t>(last[i]);
+                    if (from != npos && from != b + i && b + i - from <= max_gap)
+                        column.copy(b + i, from);
+                }
+
+                if (last[rows - 1] >= 0)
+                    carry = b + static_cast<std::size_t>(last[rows - 1]);
+            }
+        }
+
+        /**
+         * It returns the last valid row of [begin, end), npos if there is none.
+         */
+        template<typename Column>
+        [[nodiscard]] std::size_t last_valid(const Column& column, std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = end; i-- > begin; )
+            {
+                if (column.valid(i))
+                    return i;
+            }
+            return npos;
+        }
+
+        template<bool Backward, typename Column>
+        void fill(Column column, std::size_t max_gap, std::size_t threads)
+        {
+            const ordered<Column, Backward> c{ column };
+            const std::size_t rows = c.size();
+            const std::size_t blocks = (rows + block_rows - 1) / block_rows;
+            threads = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(blocks, 1));
+            if (threads == 1)
+            {
+                fill_range(c, 0, rows, npos, max_gap);
+                return;
+            }
+
+            // partitions of whole blocks of the column, so that two threads never
+            // write the same word of a validity bitmap; a backward fill sees the
+            // partitions in the reverse order
+            std::vector<std::size_t> bounds(threads + 1);
+            for (std::size_t t = 0; t <= threads; ++t)
+            {
+                const std::size_t row = std::min(rows, blocks * (Backward ? threads - t : t) / threads * block_rows);
+                bounds[t] = Backward ? rows - row : row;
+            }
+
+            std::vector<std::size_t> carries(threads, npos);
+            {
+                std::vector<std::jthread> workers;
+                for (std::size_t t = 0; t + 1 < threads; ++t)
+                    workers.emplace_back([&, t]() { carries[t + 1] = last_valid(c, bounds[t], bounds[t + 1]); });
+            }
+            for (std::size_t t = 1; t < threads; ++t)
+            {
+                if (carries[t] == npos)
+                    carries[t] = carries[t - 1];
+            }
+
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+                workers.emplace_back([&, t]() { fill_range(c, bounds[t], bounds[t + 1], carries[t], max_gap); });
+        }
+    }
+
+
+    /**
+     * Forward fill of a column of std::optional: every row without a value gets
+     * the value of the last row with a value, if it is at most max_gap rows before.
+     *
+     * \param column Column to fill
+     * \param max_gap Max distance between a filled row and the row it is copied from
+     * \param threads Number of threads
+     */
+    template<typename T>
+    void ffill(std::span<std::optional<T>> column, std::size_t max_gap = fill_no_limit, std::size_t threads = 1)
+    {
+        fill_impl::fill<false>(fill_impl::optional_column<T>{ column }, max_gap, threads);
+    }
+
+    /**
+     * Forward fill of a column with a validity bitmap: the row i has a value if
+     * the bit i % 64 of valid_bits[i / 64] is set. The bits of the filled rows are set.
+     */
+    template<typename T>
+    void ffill(std::span<T> values, std::span<std::uint64_t> valid_bits,
+        std::size_t max_gap = fill_no_limit, std::size_t threads = 1)
+    {
+        fill_impl::fill<false>(fill_impl::bitmap_column<T>{ values, valid_bits }, max_gap, threads);
+    }
+
+    /**
+     * Forward fill of a column of floating points where NaN is null.
+     */
+    template<std::floating_point T>
+    void ffill(std::span<T> values, std::size_t max_gap = fill_no_limit, std::size_t threads = 1)
+    {
+        fill_impl::fill<false>(fill_impl::nan_column<T>{ values }, max_gap, threads);
+    }
+
+    /**
+     * Backward fill of a column of std::optional: every row without a value gets
+     * the value of the next row with a value, if it is at most max_gap rows after.
+     *
+     * \param column Column to fill
+     * \param max_gap Max distance between a filled row and the row it is copied from
+     * \param threads Number of threads
+     */
+    template<typename T>
+    void bfill(std::span<std::optional<T>> column, std::size_t max_gap = fill_no_limit, std::size_t threads = 1)
+    {
+        fill_impl::fill<true>(fill_impl::optional_column<T>{ column }, max_gap, threads);
+    }
+
+    /**
+     * Backward fill of a column with a validity bitmap.
+     */
+    template<typename T>
+    void bfill(std::span<T> values, std::span<std::uint64_t> valid_bits,
+        std::size_t max_gap = fill_no_limit, std::size_t threads = 1)
+    {
+        fill_impl::fill<true>(fill_impl::bitmap_column<T>{ values, valid_bits }, max_gap, threads);
+    }
+
+    /**
+     * Backward fill of a column of floating points where NaN is null.
+     */
+    template<std::floating_point T>
+    void bfill(std::span<T> values, std::size_t max_gap = fill_no_limit, std::size_t threads = 1)
+    {
+        fill_impl::fill<true>(fill_impl::nan_column<T>{ values }, max_gap, threads);
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,297 @@
+/**********************************************************************
+ * \file   value_or_grouped.h
+ * \brief  It contains the grouped version of value_or, the SQL
+ *         FIRST_VALUE(COALESCE(columns...) IGNORE NULLS) of each key:
+ *         group_value_or_sorted(keys, columns...) for keys already
+ *         sorted (equal keys are adjacent),
+ *         group_value_or(keys, columns...) for any order of the keys,
+ *         with a flat open addressing table,
+ *         group_value_or_parallel(threads, keys, columns...) that
+ *         splits the rows between threads and merges their tables.
+ *         The columns are ranges of value holders (std::optional,
+ *         pointers, ...): the value of a row is the value of the
+ *         first column that has it, like in value_or.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_grouped_H
+#define __value_or_grouped_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace grouped_impl
+    {
+        inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        template<typename Column>
+        using value_t = std::remove_cvref_t<decltype(*std::declval<std::ranges::range_reference_t<const Column&>>())>;
+
+        /**
+         * Concept that defines a column: a random access range of value holders.
+         */
+        template<typename Column>
+        concept column = std::ranges::random_access_range<const Column&>
+            && std::ranges::sized_range<const Column&>
+            && requires(std::ranges::range_reference_t<const Column&> value_holder)
+            {
+                {!value_holder};
+                {*value_holder};
+            };
+
+        /**
+         * It returns true if at least one column has a value at the row i.
+         */
+        template<typename... Columns>
+        [[nodiscard]] constexpr bool has_value(std::size_t i, const Columns&... columns)
+        {
+            return (!!std::ranges::begin(columns)[i] || ...);
+        }
+
+        /**
+         * It returns the value of the first column that has a value at the row i,
+         * std::nullopt if i is npos.
+         */
+        template<typename V, typename... Columns>
+        [[nodiscard]] std::optional<V> row_value(std::size_t i, const Columns&... columns)
+        {
+            std::optional<V> r;
+            if (i != npos)
+            {
+                (void)((!!std::ranges::begin(columns)[i]
+                    ? (r.emplace(*std::ranges::begin(columns)[i]), true)
+                    : false) || ...);
+            }
+            return r;
+        }
+
+        /**
+         * Group of the flat table: the key is keys[first_row], value_row is the
+         * first row of the group with a value.
+         */
+        struct group
+        {
+            std::size_t first_row = npos;
+            std::size_t value_row = npos;
+        };
+
+        /**
+         * Open addressing table with linear probing. The keys are not copied,
+         * a slot refers to the first row of its group.
+         */
+        template<typename Keys, typename Hash>
+        class flat_table
+        {
+        public:
+            explicit flat_table(const Keys& keys)
+                : _keys{ keys }, _slots(16)
+            {}
+
+            /**
+             * It adds first_row to the group of keys[first_row]: the first row and the
+             * first row with a value are the minimum ones seen.
+             */
+            void add(std::size_t first_row, std::size_t value_row)
+            {
+                if ((_size + 1) * 2 > _slots.size())
+                    grow();
+                group& g = find(std::ranges::begin(_keys)[first_row]);
+                if (g.first_row == npos)
+                {
+                    ++_size;
+                    g.first_row = first_row;
+                }
+                else
+                {
+                    g.first_row = std::min(g.first_row, first_row);
+                }
+                g.value_row = std::min(g.value_row, value_row);
+            }
+
+            /**
+             * It returns the groups in order of first row.
+             */
+            [[nodiscard]] std::vector<group> groups() const
+            {
+                std::vector<group> r;
+                r.reserve(_size);
+                for (const group& g : _slots)
+                {
+                    if (g.first_row != npos)
+                        r.push_back(g);
+                }
+                std::ranges::sort(r, {}, &group::first_row);
+                return r;
+            }
+
+        private:
+            template<typename K>
+            group& find(const K& key)
+            {
+                // Fibonacci hashing: the high bits of the product depend on all the
+                // bits of the hash, std::hash of the integers is the identity
+                const std::size_t mask = _slots.size() - 1;
+                const int shift = 64 - std::countr_zero(_slots.size());
+                const std::size_t first = static_cast<std::size_t>(
+                    (static_cast<std::uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+                for (std::size_t s = first; ; s = (s + 1) & mask)
+                {
+                    group& g = _slots[s];
+                    if (g.first_row == npos || std::ranges::begin(_keys)[g.first_row] == key)
+                        return g;
+                }
+            }
+
+            void grow()
+            {
+                std::vector<group> old(_slots.size() * 2);
+                old.swap(_slots);
+                for (const group& g : old)
+                {
+                    if (g.first_row != npos)
+                        find(std::ranges::begin(_keys)[g.first_row]) = g;
+                }
+            }
+
+            const Keys& _keys;
+            std::vector<group> _slots;
+            std::size_t _size = 0;
+        };
+
+        template<typename Keys, typename Hash, typename... Columns>
+        void add_rows(flat_table<Keys, Hash>& table, std::size_t begin, std::size_t end, const Columns&... columns)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                table.add(i, has_value(i, columns...) ? i : npos);
+        }
+
+        template<typename Keys, typename V, typename... Columns>
+        [[nodiscard]] auto make_result(const Keys& keys, const std::vector<group>& groups, const Columns&... columns)
+        {
+            std::vector<std::pair<std::ranges::range_value_t<const Keys&>, std::optional<V>>> r;
+            r.reserve(groups.size());
+            for (const group& g : groups)
+                r.emplace_back(std::ranges::begin(keys)[g.first_row], row_value<V>(g.value_row, columns...));
+            return r;
+        }
+    }
+
+
+    /**
+     * Grouped value_or for sorted keys: the rows with the same key must be
+     * adjacent. For every group of rows with the same key it returns the
+     * key and the value of the first row that has a value, std::nullopt if
+     * no row of the group has a value.
+     *
+     * \param keys Keys of the rows
+     * \param column_0 First column to check
+     * \param ...column_v Next columns to check
+     * \return Pairs (key, first value of the group), in the order of the keys
+     */
+    template<std::ranges::random_access_range Keys, grouped_impl::column Column, grouped_impl::column... Columns>
+    requires std::ranges::sized_range<const Keys&>
+    [[nodiscard]] auto group_value_or_sorted(const Keys& keys, const Column& column_0, const Columns&... column_v)
+    {
+        using V = grouped_impl::value_t<Column>;
+        std::vector<grouped_impl::group> groups;
+
+        const auto k = std::ranges::begin(keys);
+        const std::size_t rows = std::ranges::size(keys);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            if (i == 0 || !(k[i] == k[groups.back().first_row]))
+                groups.push_back({ i, grouped_impl::npos });
+
+            grouped_impl::group& g = groups.back();
+            if (g.value_row == grouped_impl::npos && grouped_impl::has_value(i, column_0, column_v...))
+                g.value_row = i;
+        }
+        return grouped_impl::make_result<Keys, V>(keys, groups, column_0, column_v...);
+    }
+
+    /**
+     * Grouped value_or with a hash table: the keys can be in any order.
+     * For every key it returns the value of the first row, in row order,
+     * that has a value, std::nullopt if no row of the key has a value.
+     *
+     * \param keys Keys of the rows
+     * \param column_0 First column to check
+     * \param ...column_v Next columns to check
+     * \return Pairs (key, first value of the key), in order of first appearance of the keys
+     */
+    template<std::ranges::random_access_range Keys, grouped_impl::column Column, grouped_impl::column... Columns>
+    requires std::ranges::sized_range<const Keys&>
+    [[nodiscard]] auto group_value_or(const Keys& keys, const Column& column_0, const Columns&... column_v)
+    {
+        using V = grouped_impl::value_t<Column>;
+        using Hash = std::hash<std::ranges::range_value_t<const Keys&>>;
+
+        grouped_impl::flat_table<Keys, Hash> table{ keys };
+        grouped_impl::add_rows(table, 0, std::ranges::size(keys), column_0, column_v...);
+        return grouped_impl::make_result<Keys, V>(keys, table.groups(), column_0, column_v...);
+    }
+
+    /**
+     * Multi-threaded version of group_value_or: the rows are split in threads
+     * contiguous partitions, each thread builds its own table, then the tables
+     * are merged keeping the minimum rows, so the result is the same of
+     * group_value_or.
+     *
+     * \param threads Number of threads
+     * \param keys Keys of the rows
+     * \param column_0 First column to check
+     * \param ...column_v Next columns to check
+     * \return Pairs (key, first value of the key), in order of first appearance of the keys
+     */
+    template<std::ranges::random_access_range Keys, grouped_impl::column Column, grouped_impl::column... Columns>
+    requires std::ranges::sized_range<const Keys&>
+    [[nodiscard]] auto group_value_or_parallel(std::size_t threads, const Keys& keys,
+        const Column& column_0, const Columns&... column_v)
+    {
+        using V = grouped_impl::value_t<Column>;
+        using Hash = std::hash<std::ranges::range_value_t<const Keys&>>;
+        using table = grouped_impl::flat_table<Keys, Hash>;
+
+        const std::size_t rows = std::ranges::size(keys);
+        threads = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(rows, 1));
+
+        std::vector<table> tables(threads, table{ keys });
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&, t]()
+                {
+                    grouped_impl::add_rows(tables[t], rows * t / threads, rows * (t + 1) / threads,
+                        column_0, column_v...);
+                });
+            }
+        }
+
+        table merged{ keys };
+        for (const table& partial : tables)
+        {
+            for (const grouped_impl::group& g : partial.groups())
+                merged.add(g.first_row, g.value_row);
+        }
+        return grouped_impl::make_result<Keys, V>(keys, merged.groups(), column_0, column_v...);
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,121 @@
+/**********************************************************************
+ * \file   value_or_instance.h
+ * \brief  It contains value_or_canonical(default_value, to_test_v...)
+ *         and the macros to instantiate it in a single translation
+ *         unit.
+ *         value_or is a template for every permutation of the types
+ *         of its parameters, const and references included.
+ *         value_or_canonical removes const and references, and
+ *         passes the pointers T* as const T*, so all the variants of
+ *         a signature share one function:
+ *         value_or_instance<R, DT, Args...>::call.
+ *         call is not inline, so it can be declared extern template
+ *         in a header, with S4_VALUE_OR_EXTERN, and instantiated in
+ *         one translation unit, with S4_VALUE_OR_INSTANTIATE: the
+ *         other translation units call it and do not generate it.
+ *         extern template has no effect on value_or itself, because
+ *         it is constexpr, so inline.
+ *         value_or_common_instances.h declares extern a list of common
+ *         instances, defined in value_or_codegen/common_instances.cpp.
+ *
+ *         // value_or_instances.h, included where value_or_canonical is used
+ *         #define MY_INSTANCES(X) \
+ *             X(int, const int*, std::optional<int>) \
+ *             X(std::string, std::string*, std::shared_ptr<std::string>)
+ *         MY_INSTANCES(S4_VALUE_OR_EXTERN)
+ *
+ *         // value_or_instances.cpp
+ *         #include "value_or_instances.h"
+ *         MY_INSTANCES(S4_VALUE_OR_INSTANTIATE)
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_instance_H
+#define __value_or_instance_H
+
+#include <type_traits>
+#include <utility>
+
+#include "value_or.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace instance_impl
+    {
+        template<typename T>
+        struct canonical
+        {
+            using type = std::remove_cvref_t<T>;
+        };
+
+        template<typename T>
+        struct canonical<T*>
+        {
+            using type = const std::remove_cv_t<T>*;
+        };
+
+        /**
+         * Type of a value holder in value_or_instance: without const and
+         * references, and const T* for the pointers.
+         */
+        template<typename T>
+        using canonical_t = typename canonical<std::remove_cvref_t<T>>::type;
+    }
+
+    /**
+     * Out of line value_or for the default value type DT and the value holder
+     * types Args, without const and references; R is the returned type.
+     */
+    template<typename R, typename DT, typename... Args>
+    struct value_or_instance
+    {
+        static R call(const DT& default_value, const Args&... to_test_v);
+    };
+
+    template<typename R, typename DT, typename... Args>
+    R value_or_instance<R, DT, Args...>::call(const DT& default_value, const Args&... to_test_v)
+    {
+        return s4::value_or(default_value, to_test_v...);
+    }
+
+
+    /**
+     * Version of value_or that calls value_or_instance: the value holders are
+     * passed as const references, and the result is a copy of the value found.
+     * All the const and reference variants of a signature use the same function,
+     * and the pointers T* use the instance of const T*.
+     *
+     * \param default_value Value to return if all the values are null
+     * \param ...to_test_v Values to check
+     * \return A copy of the first value not null, or of default_value
+     */
+    template<typename DT, typename... Args>
+    [[nodiscard]] std::remove_cvref_t<DT> value_or_canonical(const DT& default_value, const Args&... to_test_v)
+    {
+        using R = std::remove_cvref_t<DT>;
+        return value_or_instance<R, R, instance_impl::canonical_t<Args>...>::call(default_value, to_test_v...);
+    }
+
+} // end namespace s4
+
+
+/**
+ * Declaration of the instance of value_or_canonical(DT, Args...): the
+ * translation units that see it do not generate the function.
+ * The types cannot have commas, use an alias for them.
+ */
+#define S4_VALUE_OR_EXTERN(DT, ...) \
+    extern template struct s4::value_or_instance<DT, DT, __VA_ARGS__>;
+
+/**
+ * Definition of the instance of value_or_canonical(DT, Args...), it must
+ * be in one translation unit.
+ */
+#define S4_VALUE_OR_INSTANTIATE(DT, ...) \
+    template struct s4::value_or_instance<DT, DT, __VA_ARGS__>;
+
+#endif
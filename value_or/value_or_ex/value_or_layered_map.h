@@ -0,0 +1,584 @@
+/**********************************************************************
+ * \file   value_or_layered_map.h
+ * \brief  It contains the class layered_map<K, V>: a map made of
+ *         layers, the layer 0 has the highest priority. The value
+ *         of a key is the one of the first layer that has the key,
+ *         like value_or(default_value, layer0.get(k), layer1.get(k), ...).
+ *         layered_map keeps a resolved snapshot of the layers: a
+ *         hash table whose buckets are the leaves of a tree with 64
+ *         children per node. A read hashes the key once and probes
+ *         one bucket, whatever the number of layers and of writes.
+ *         An update copies only the buckets of the keys it changes
+ *         and the nodes on their paths, the rest of the snapshot is
+ *         shared, so a write costs the keys it changes, not the size
+ *         of the map; the table doubles its buckets when the keys
+ *         are more than the buckets.
+ *         The readers never take a lock: the old snapshots are
+ *         released with an epoch based reclamation.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_layered_map_H
+#define __value_or_layered_map_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "value_or_range.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace layered_map_impl
+    {
+        /**
+         * Epoch based reclamation shared by all the layered_maps.
+         * Every reader thread owns a slot, where it writes the global epoch
+         * while it reads a snapshot and 0 when it is idle. A snapshot retired
+         * at the epoch e can be deleted when no slot holds an epoch lower
+         * than e. If all the slots are used, the other readers increment the
+         * overflow counter, and nothing is deleted while it is not 0: the
+         * readers never wait.
+         */
+        class epoch_domain
+        {
+        public:
+            static constexpr std::size_t max_readers = 256;
+
+            struct alignas(64) slot
+            {
+                std::atomic<std::uint64_t> epoch{ 0 };
+                std::atomic<bool> used{ false };
+            };
+
+            static epoch_domain& instance() noexcept
+            {
+                static epoch_domain domain;
+                return domain;
+            }
+
+            /**
+             * State of the calling thread: its slot, if it has one, and the
+             * depth of the nested read_guards.
+             */
+            struct reader
+            {
+                slot* s = nullptr;
+                std::size_t depth = 0;
+                bool overflow = false;
+
+                ~reader()
+                {
+                    if (s)
+                        s->used.store(false, std::memory_order_release);
+                }
+            };
+
+            static reader& local_reader() noexcept
+            {
+                thread_local reader r;
+                return r;
+            }
+
+            /**
+             * It assigns a free slot to the reader, if there is one: it never
+             * waits, the readers without a slot use the overflow counter.
+             */
+            bool acquire_slot(reader& r) noexcept
+            {
+                for (slot& s : _slots)
+                {
+                    bool expected = false;
+                    if (!s.used.load(std::memory_order_relaxed)
+                        && s.used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    {
+                        r.s = &s;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Readers without a slot: while it is not 0 no view is deleted.
+             */
+            std::atomic<std::size_t>& overflow() noexcept
+            {
+                return _overflow;
+            }
+
+            std::uint64_t current() const noexcept
+            {
+                return _epoch.load();
+            }
+
+            /**
+             * It starts a new epoch, and returns it. It must be called after
+             * the publication of a new view, the old view is retired at
+             * the returned epoch.
+             */
+            std::uint64_t advance() noexcept
+            {
+                return _epoch.fetch_add(1) + 1;
+            }
+
+            /**
+             * It returns the lowest epoch of the active readers, or
+             * UINT64_MAX if no reader is active; 0 if a reader without a slot
+             * is active, whose epoch is unknown.
+             */
+            std::uint64_t min_active() const noexcept
+            {
+                if (_overflow.load() != 0)
+                    return 0;
+                std::uint64_t m = UINT64_MAX;
+                for (const slot& s : _slots)
+                {
+                    const std::uint64_t e = s.epoch.load();
+                    if (e != 0 && e < m)
+                        m = e;
+                }
+                return m;
+            }
+
+        private:
+            epoch_domain() = default;
+
+            std::atomic<std::uint64_t> _epoch{ 1 };
+            std::atomic<std::size_t> _overflow{ 0 };
+            slot _slots[max_readers];
+        };
+
+
+        /**
+         * It marks the calling thread as reader for its lifetime. The guards
+         * can be nested, only the outermost one publishes the epoch.
+         * If all the slots are used the reader takes the overflow counter,
+         * that delays the reclamation, instead of waiting for a slot.
+         */
+        class read_guard
+        {
+        public:
+            read_guard() noexcept
+                : _reader{ epoch_domain::local_reader() }
+            {
+                if (_reader.depth++ != 0)
+                    return;
+
+                epoch_domain& domain = epoch_domain::instance();
+                if (_reader.s || domain.acquire_slot(_reader))
+                {
+                    _reader.s->epoch.store(domain.current());
+                }
+                else
+                {
+                    _reader.overflow = true;
+                    domain.overflow().fetch_add(1);
+                }
+            }
+
+            ~read_guard()
+            {
+                if (--_reader.depth != 0)
+                    return;
+
+                if (_reader.overflow)
+                {
+                    _reader.overflow = false;
+                    epoch_domain::instance().overflow().fetch_sub(1, std::memory_order_release);
+                }
+                else
+                {
+                    _reader.s->epoch.store(0, std::memory_order_release);
+                }
+            }
+
+            read_guard(const read_guard&) = delete;
+            read_guard& operator=(const read_guard&) = delete;
+
+        private:
+            epoch_domain::reader& _reader;
+        };
+    }
+
+
+    /**
+     * Map made of layers, where the layer 0 has the highest priority.
+     * The value of a key is the value of the first layer that has the key.
+     * The reads are lock free and see a consistent snapshot of all the layers;
+     * the writes are serialized by a mutex, and publish a snapshot that shares
+     * with the previous one all the buckets whose keys have not changed.
+     */
+    template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class layered_map
+    {
+    public:
+        using layer_type = std::unordered_map<K, V, Hash, KeyEqual>;
+
+        /**
+         * \param layers Number of layers
+         */
+        explicit layered_map(std::size_t layers)
+            : _layers(layers), _snapshot{ new snapshot{ empty_snapshot() } }
+        {}
+
+        layered_map(const layered_map&) = delete;
+        layered_map& operator=(const layered_map&) = delete;
+
+        /**
+         * No reader can be active when the map is destroyed.
+         */
+        ~layered_map()
+        {
+            delete _snapshot.load();
+            for (const auto& r : _retired)
+                delete r.first;
+        }
+
+        [[nodiscard]] std::size_t layers() const noexcept
+        {
+            return _layers.size();
+        }
+
+        /**
+         * It returns the value of key, from the first layer that has it.
+         * It is lock free. The result can be passed to value_or.
+         *
+         * \param key Key to look for
+         * \return The value of key, std::nullopt if no layer has key
+         */
+        [[nodiscard]] std::optional<V> get(const K& key) const
+        {
+            layered_map_impl::read_guard guard;
+            const entry* e = _snapshot.load()->find(key);
+            return e == nullptr ? std::nullopt : std::optional<V>{ e->value };
+        }
+
+        /**
+         * It returns the index of the layer that supplies the value of key,
+         * value_or_npos if no layer has key.
+         */
+        [[nodiscard]] std::size_t layer_of(const K& key) const
+        {
+            layered_map_impl::read_guard guard;
+            const entry* e = _snapshot.load()->find(key);
+            return e == nullptr ? value_or_npos : e->layer;
+        }
+
+        /**
+         * It returns the number of keys that have a value in some layer.
+         */
+        [[nodiscard]] std::size_t size() const
+        {
+            layered_map_impl::read_guard guard;
+            return _snapshot.load()->size;
+        }
+
+        /**
+         * It sets the value of key in a layer.
+         *
+         * \throw std::out_of_range if layer is not less than layers()
+         */
+        void set(std::size_t layer, const K& key, V value)
+        {
+            const std::pair<K, std::optional<V>> change{ key, std::move(value) };
+            update(layer, std::span(&change, 1));
+        }
+
+        /**
+         * It removes key from a layer.
+         *
+         * \throw std::out_of_range if layer is not less than layers()
+         */
+        void erase(std::size_t layer, const K& key)
+        {
+            const std::pair<K, std::optional<V>> change{ key, std::nullopt };
+            update(layer, std::span(&change, 1));
+        }
+
+        /**
+         * It applies a set of changes to a layer and publishes them together:
+         * a change with std::nullopt removes the key from the layer.
+         * Only the keys of the changes are recomputed, and only the keys
+         * whose value comes from layer or from a lower priority layer; their
+         * buckets are copied in a new snapshot, the rest is shared.
+         *
+         * \param layer Layer to update
+         * \param changes Keys to set or to remove
+         * \throw std::out_of_range if layer is not less than layers()
+         */
+        void update(std::size_t layer, std::span<const std::pair<K, std::optional<V>>> changes)
+        {
+            if (layer >= _layers.size())
+                throw std::out_of_range("layered_map: layer out of range");
+
+            std::lock_guard lock{ _write_mutex };
+
+            snapshot next{ *_snapshot.load() };
+            bool changed = false;
+
+            for (const auto& [key, value] : changes)
+            {
+                if (value)
+                    _layers[layer].insert_or_assign(key, *value);
+                else if (_layers[layer].erase(key) == 0)
+                    continue;
+
+                const entry* e = next.find(key);
+                if (e != nullptr && e->layer < layer)
+                    continue; // the key is hidden by a layer with a higher priority
+
+                next.assign(key, resolve(key));
+                changed = true;
+            }
+
+            if (!changed)
+                return;
+
+            while (next.size > next.bucket_mask() + 1)
+                next = next.grown();
+            publish(new snapshot{ std::move(next) });
+        }
+
+    private:
+        struct entry
+        {
+            V value;
+            std::size_t layer;
+        };
+
+        using bucket = std::vector<std::pair<K, entry>>;
+
+        static constexpr std::size_t fanout_bits = 6;
+        static constexpr std::size_t fanout_mask = (std::size_t{ 1 } << fanout_bits) - 1;
+
+        /**
+         * Node of the tree of the buckets: the leaves have the buckets, null
+         * when empty, the other nodes the children. The nodes and the buckets
+         * are never changed after they are published, the writer copies them.
+         */
+        struct node
+        {
+            std::vector<std::shared_ptr<const node>> children;
+            std::vector<std::shared_ptr<const bucket>> buckets;
+        };
+
+        /**
+         * Resolved layers: 2^bits buckets, the bucket of a key is selected by
+         * the low bits of its hash, fanout_bits at every level of the tree.
+         * The readers only follow the pointers, the reference counts are
+         * changed only by the writer.
+         */
+        struct snapshot
+        {
+            std::shared_ptr<const node> root;
+            std::size_t bits;
+            std::size_t size;
+
+            [[nodiscard]] std::size_t bucket_mask() const noexcept
+            {
+                return (std::size_t{ 1 } << bits) - 1;
+            }
+
+            // shift of the bits of the bucket index used by the root
+            [[nodiscard]] std::size_t top_shift() const noexcept
+            {
+                return (bits - 1) / fanout_bits * fanout_bits;
+            }
+
+            [[nodiscard]] const entry* find(const K& key) const
+            {
+                const std::size_t b = static_cast<std::size_t>(Hash{}(key)) & bucket_mask();
+                const node* n = root.get();
+                for (std::size_t shift = top_shift(); shift != 0; shift -= fanout_bits)
+                    n = n->children[(b >> shift) & fanout_mask].get();
+
+                if (const bucket* bk = n->buckets[b & fanout_mask].get())
+                {
+                    for (const auto& [k, e] : *bk)
+                    {
+                        if (KeyEqual{}(k, key))
+                            return &e;
+                    }
+                }
+                return nullptr;
+            }
+
+            /**
+             * It sets the entry of key, or removes it if e is std::nullopt:
+             * it copies the bucket of key and the nodes on its path.
+             */
+            void assign(const K& key, const std::optional<entry>& e)
+            {
+                const std::size_t b = static_cast<std::size_t>(Hash{}(key)) & bucket_mask();
+                root = assign(*root, top_shift(), b, key, e);
+            }
+
+            std::shared_ptr<const node> assign(const node& n, std::size_t shift, std::size_t b,
+                const K& key, const std::optional<entry>& e)
+            {
+                auto copy = std::make_shared<node>(n);
+                if (shift != 0)
+                {
+                    auto& child = copy->children[(b >> shift) & fanout_mask];
+                    child = assign(*child, shift - fanout_bits, b, key, e);
+                    return copy;
+                }
+
+                auto& slot = copy->buckets[b & fanout_mask];
+                bucket bk = slot ? *slot : bucket{};
+                const auto it = std::find_if(bk.begin(), bk.end(), [&key](const auto& p) { return KeyEqual{}(p.first, key); });
+                if (it != bk.end())
+                {
+                    if (e)
+                    {
+                        it->second = *e;
+                    }
+                    else
+                    {
+                        bk.erase(it);
+                        --size;
+                    }
+                }
+                else if (e)
+                {
+                    bk.emplace_back(key, *e);
+                    ++size;
+                }
+                slot = bk.empty() ? nullptr : std::make_shared<const bucket>(std::move(bk));
+                return copy;
+            }
+
+            /**
+             * It returns a copy with twice the buckets: all the keys are
+             * copied, it is amortized by the keys added since the last growth.
+             */
+            [[nodiscard]] snapshot grown() const
+            {
+                std::vector<bucket> buckets(std::size_t{ 2 } << bits);
+                collect(*root, top_shift(), [&buckets](const auto& p)
+                {
+                    buckets[static_cast<std::size_t>(Hash{}(p.first)) & (buckets.size() - 1)].push_back(p);
+                });
+                return make(std::move(buckets), bits + 1, size);
+            }
+
+            template<typename F>
+            static void collect(const node& n, std::size_t shift, F&& f)
+            {
+                if (shift != 0)
+                {
+                    for (const auto& child : n.children)
+                        collect(*child, shift - fanout_bits, f);
+                    return;
+                }
+                for (const auto& bk : n.buckets)
+                {
+                    if (bk)
+                    {
+                        for (const auto& p : *bk)
+                            f(p);
+                    }
+                }
+            }
+
+            [[nodiscard]] static snapshot make(std::vector<bucket> buckets, std::size_t bits, std::size_t size)
+            {
+                snapshot r{ nullptr, bits, size };
+                r.root = build(buckets, 0, buckets.size(), r.top_shift());
+                return r;
+            }
+
+            /**
+             * It builds the subtree of the buckets [first, first + count).
+             */
+            [[nodiscard]] static std::shared_ptr<const node> build(std::vector<bucket>& buckets,
+                std::size_t first, std::size_t count, std::size_t shift)
+            {
+                auto n = std::make_shared<node>();
+                if (shift != 0)
+                {
+                    const std::size_t child_count = std::size_t{ 1 } << shift;
+                    n->children.reserve(count / child_count);
+                    for (std::size_t c = first; c < first + count; c += child_count)
+                        n->children.push_back(build(buckets, c, child_count, shift - fanout_bits));
+                    return n;
+                }
+                n->buckets.reserve(count);
+                for (std::size_t b = first; b < first + count; ++b)
+                {
+                    n->buckets.push_back(buckets[b].empty() ? nullptr
+                        : std::make_shared<const bucket>(std::move(buckets[b])));
+                }
+                return n;
+            }
+        };
+
+        [[nodiscard]] static snapshot empty_snapshot()
+        {
+            return snapshot::make(std::vector<bucket>(std::size_t{ 1 } << fanout_bits), fanout_bits, 0);
+        }
+
+        /**
+         * It returns the value of key resolved from the layers.
+         */
+        [[nodiscard]] std::optional<entry> resolve(const K& key) const
+        {
+            std::vector<const V*> values(_layers.size(), nullptr);
+            for (std::size_t l = 0; l < _layers.size(); ++l)
+            {
+                const auto it = _layers[l].find(key);
+                if (it != _layers[l].end())
+                    values[l] = &it->second;
+            }
+
+            const std::size_t l = value_or_range_index(values);
+            if (l == value_or_npos)
+                return std::nullopt;
+            return entry{ *values[l], l };
+        }
+
+        /**
+         * It publishes new_snapshot, retires the old one and deletes the
+         * retired snapshots that no reader can see.
+         */
+        void publish(const snapshot* new_snapshot)
+        {
+            auto& domain = layered_map_impl::epoch_domain::instance();
+
+            const snapshot* old_snapshot = _snapshot.exchange(new_snapshot);
+            _retired.emplace_back(old_snapshot, domain.advance());
+
+            const std::uint64_t min_active = domain.min_active();
+            std::erase_if(_retired, [min_active](const auto& r)
+            {
+                if (r.second > min_active)
+                    return false;
+                delete r.first;
+                return true;
+            });
+        }
+
+        std::vector<layer_type> _layers;
+        std::atomic<const snapshot*> _snapshot;
+        std::vector<std::pair<const snapshot*, std::uint64_t>> _retired;
+        std::mutex _write_mutex;
+    };
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,197 @@
+/**********************************************************************
+ * \file   value_or_lookup.h
+ * \brief  It contains the function:
+ *         lookup_first(keys, out, maps...).
+ *         For every key it looks for the key in the maps, in priority
+ *         order, and writes in out a pointer to the value of the first
+ *         map that has it: it is a batch of
+ *         value_or(nullptr, maps.find(key)...).
+ *         The keys are processed in groups, and each group is
+ *         resolved a map at a time. For the maps with buckets
+ *         (std::unordered_map and the maps with its interface, whose
+ *         bucket() accepts the keys) every key of the group is
+ *         hashed once by bucket(), then the first nodes of
+ *         all the buckets are read and prefetched, so the cache
+ *         misses of the group overlap, and at last the buckets are
+ *         walked from the nodes already read, without hashing the
+ *         keys again. The other maps use find.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_lookup_H
+#define __value_or_lookup_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Concept that defines a map that can be used by lookup_first with keys of
+     * type Key: it must have find(key), that can be heterogeneous, and
+     * find(key)->second must be a mapped_type.
+     */
+    template<typename Map, typename Key>
+    concept lookup_map = requires(const Map& map, const Key& key)
+    {
+        typename Map::mapped_type;
+        { map.find(key) == map.end() } -> std::convertible_to<bool>;
+        { map.find(key)->second } -> std::convertible_to<const typename Map::mapped_type&>;
+    };
+
+
+    namespace lookup_impl
+    {
+        // number of keys resolved together
+        inline constexpr std::size_t group_size = 16;
+
+        inline void prefetch(const void* p) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+            (void)p;
+#endif
+        }
+
+        /**
+         * Maps with buckets whose bucket() and key equality accept Key: they
+         * are probed through the buckets, with the hash computed once.
+         */
+        template<typename Map, typename Key>
+        concept bucketed = requires(const Map& map, const Key& key, std::size_t b)
+        {
+            { map.bucket_count() } -> std::convertible_to<std::size_t>;
+            { map.bucket(key) } -> std::convertible_to<std::size_t>;
+            { map.key_eq()(map.begin(b)->first, key) } -> std::convertible_to<bool>;
+            map.end(b);
+        };
+
+        /**
+         * It resolves the keys of a group, whose indexes are in pending, in map:
+         * the keys found are written in out and removed from pending.
+         * For a bucketed map the bucket is map.bucket(key), the mapping of the
+         * map itself, so the hash is computed once. The first node of each
+         * bucket is read once, for all the keys of the group, before the walk
+         * of the buckets: only the nodes are prefetched, the standard
+         * interface does not give the address of the bucket.
+         *
+         * \return The number of keys still pending
+         */
+        template<typename Keys, typename V, typename Map>
+        std::size_t resolve(const Keys& keys, std::span<const V*> out,
+            std::size_t* pending, std::size_t pending_count, const Map& map)
+        {
+            std::size_t still_pending = 0;
+            if constexpr (bucketed<Map, std::ranges::range_value_t<Keys>>)
+            {
+                if (map.bucket_count() == 0)
+                    return pending_count;
+
+                std::size_t bucket[group_size];
+                typename Map::const_local_iterator first[group_size];
+                for (std::size_t p = 0; p < pending_count; ++p)
+                {
+                    bucket[p] = static_cast<std::size_t>(map.bucket(std::ranges::begin(keys)[pending[p]]));
+                    first[p] = map.begin(bucket[p]);
+                    if (first[p] != map.end(bucket[p]))
+                        prefetch(std::addressof(*first[p]));
+                }
+
+                for (std::size_t p = 0; p < pending_count; ++p)
+                {
+                    const std::size_t i = pending[p];
+                    const auto& key = std::ranges::begin(keys)[i];
+                    auto it = first[p];
+                    const auto last = map.end(bucket[p]);
+                    while (it != last && !map.key_eq()(it->first, key))
+                        ++it;
+                    if (it != last)
+                        out[i] = std::addressof(it->second);
+                    else
+                        pending[still_pending++] = i;
+                }
+            }
+            else
+            {
+                for (std::size_t p = 0; p < pending_count; ++p)
+                {
+                    const std::size_t i = pending[p];
+                    const auto it = map.find(std::ranges::begin(keys)[i]);
+                    if (it != map.end())
+                        out[i] = std::addressof(it->second);
+                    else
+                        pending[still_pending++] = i;
+                }
+            }
+            return still_pending;
+        }
+    }
+
+
+    /**
+     * For every element of keys it looks for the key in the maps, in priority
+     * order: out[i] points to the value of keys[i] in the first map that has it,
+     * it is nullptr if no map has the key. A map is probed only for the keys
+     * not found in the previous maps.
+     * out must have at least keys.size() elements; the pointers are valid until
+     * the maps are changed. They can be passed to value_or.
+     *
+     * \param keys Keys to look for, for example a std::span<const std::string_view>
+     *        with maps that have an heterogeneous find
+     * \param out Pointers to the values found
+     * \param map_0 Map with the highest priority
+     * \param ...map_v Other maps, in priority order
+     * \return Number of keys found
+     */
+    template<std::ranges::random_access_range Keys, typename Map, typename... Maps>
+    requires std::ranges::sized_range<Keys>
+        && lookup_map<Map, std::ranges::range_value_t<Keys>>
+        && (lookup_map<Maps, std::ranges::range_value_t<Keys>> && ...)
+        && (std::same_as<typename Map::mapped_type, typename Maps::mapped_type> && ...)
+    std::size_t lookup_first(const Keys& keys, std::span<const typename Map::mapped_type*> out,
+        const Map& map_0, const Maps&... map_v)
+    {
+        std::size_t found = 0;
+        std::size_t pending[lookup_impl::group_size];
+
+        for (std::size_t begin = 0; begin < std::ranges::size(keys); begin += lookup_impl::group_size)
+        {
+            const std::size_t group = std::min(lookup_impl::group_size, std::ranges::size(keys) - begin);
+            std::size_t pending_count = group;
+            for (std::size_t p = 0; p < group; ++p)
+            {
+                pending[p] = begin + p;
+                out[begin + p] = nullptr;
+            }
+
+            // the maps are tried in order, until no key of the group is pending
+            pending_count = lookup_impl::resolve(keys, out, pending, pending_count, map_0);
+            ((pending_count = pending_count == 0 ? 0
+                : lookup_impl::resolve(keys, out, pending, pending_count, map_v)), ...);
+
+            found += group - pending_count;
+        }
+        return found;
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,169 @@
+/**********************************************************************
+ * \file   value_or_pmr.h
+ * \brief  It contains the batch versions of value_or for values that
+ *         allocate memory (std::string, std::vector, ...):
+ *         value_or_materialize<T>(default_value, resource, columns...)
+ *         copies the result of every row in a std::pmr::vector<T>,
+ *         whose elements allocate from resource too (for example a
+ *         std::pmr::monotonic_buffer_resource for each batch),
+ *         value_or_borrow(default_value, resource, columns...) and
+ *         value_or_string_view(...) copy nothing: they return
+ *         references to the values of the columns.
+ *         The columns are ranges of value holders (std::optional,
+ *         pointers, std::unique_ptr, ...) and every row is resolved
+ *         with value_or.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_pmr_H
+#define __value_or_pmr_H
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <ranges>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "value_or.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace pmr_impl
+    {
+        /**
+         * Concept that defines a column: a random access range of value holders
+         * of V that own or point to the value (std::optional, pointers, ...).
+         * std::weak_ptr is not a column: the result could outlive the value.
+         * The elements must be lvalues: a view that returns the value holders
+         * by value (views::transform returning a std::optional) is not a
+         * column, because row would refer to a destroyed temporary.
+         * For the same reason the value must be an lvalue of V, or of a class
+         * derived from V: a value converted to V (a const char* for a
+         * std::string) would be a temporary.
+         */
+        template<typename Column, typename V>
+        concept column = std::ranges::random_access_range<const Column&>
+            && std::ranges::sized_range<const Column&>
+            && std::is_lvalue_reference_v<std::ranges::range_reference_t<const Column&>>
+            && requires(std::ranges::range_reference_t<const Column&> value_holder)
+            {
+                {!value_holder} -> std::convertible_to<bool>;
+                requires std::is_lvalue_reference_v<decltype(*value_holder)>;
+                requires std::same_as<std::remove_cvref_t<decltype(*value_holder)>, V>
+                    || std::derived_from<std::remove_cvref_t<decltype(*value_holder)>, V>;
+            };
+
+        /**
+         * It returns the value of the row i: value_or(default_value, columns[i]...).
+         * It is a reference to default_value or to the value of a column.
+         */
+        template<typename V, typename... Columns>
+        [[nodiscard]] const V& row(const V& default_value, std::size_t i, const Columns&... columns)
+        {
+            return s4::value_or(default_value, std::ranges::begin(columns)[i]...);
+        }
+
+        template<typename Column, typename... Columns>
+        [[nodiscard]] std::size_t rows(const Column& column_0, const Columns&...)
+        {
+            return std::ranges::size(column_0);
+        }
+
+        /**
+         * It appends to out a copy of v, the copy uses the allocator of out:
+         * T(v, allocator) if T has that constructor (std::pmr::string from a
+         * std::string), T(begin(v), end(v), allocator) otherwise (std::pmr::vector
+         * from a std::vector).
+         */
+        template<typename T, typename V>
+        void append(std::pmr::vector<T>& out, const V& v)
+        {
+            if constexpr (std::uses_allocator_v<T, std::pmr::polymorphic_allocator<T>>
+                && !std::is_constructible_v<T, const V&, std::pmr::polymorphic_allocator<T>>
+                && std::ranges::input_range<const V&>)
+            {
+                out.emplace_back(std::ranges::begin(v), std::ranges::end(v));
+            }
+            else
+            {
+                out.emplace_back(v);
+            }
+        }
+    }
+
+
+    /**
+     * It applies value_or to every row of the columns and copies the results in
+     * a std::pmr::vector<T> that allocates from resource. If T uses allocators
+     * (std::pmr::string, std::pmr::vector, ...) the elements allocate from resource
+     * too, so a batch makes no allocation from the global allocator.
+     * All the columns must have the same number of rows.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param resource Memory resource of the result and of its elements
+     * \param column_0 First column to check
+     * \param ...column_v Next columns to check
+     * \return The results of the rows
+     */
+    template<typename T, typename V, pmr_impl::column<V> Column, pmr_impl::column<V>... Columns>
+    [[nodiscard]] std::pmr::vector<T> value_or_materialize(const V& default_value, std::pmr::memory_resource* resource,
+        const Column& column_0, const Columns&... column_v)
+    {
+        const std::size_t rows = pmr_impl::rows(column_0);
+        std::pmr::vector<T> out{ resource };
+        out.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+            pmr_impl::append(out, pmr_impl::row(default_value, i, column_0, column_v...));
+        return out;
+    }
+
+    /**
+     * Borrow version of value_or_materialize: no value is copied, the result
+     * refers to default_value or to the values of the columns, and it is valid
+     * as long as them.
+     *
+     * \param default_value Value to use for the rows where all the columns are null
+     * \param resource Memory resource of the result
+     * \param column_0 First column to check
+     * \param ...column_v Next columns to check
+     * \return References to the results of the rows
+     */
+    template<typename V, pmr_impl::column<V> Column, pmr_impl::column<V>... Columns>
+    [[nodiscard]] std::pmr::vector<std::reference_wrapper<const V>> value_or_borrow(const V& default_value,
+        std::pmr::memory_resource* resource, const Column& column_0, const Columns&... column_v)
+    {
+        const std::size_t rows = pmr_impl::rows(column_0);
+        std::pmr::vector<std::reference_wrapper<const V>> out{ resource };
+        out.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+            out.emplace_back(pmr_impl::row(default_value, i, column_0, column_v...));
+        return out;
+    }
+
+    /**
+     * Borrow version of value_or_materialize for strings: the result is a view
+     * of default_value or of the strings of the columns.
+     */
+    template<typename V, pmr_impl::column<V> Column, pmr_impl::column<V>... Columns>
+    requires std::is_convertible_v<const V&, std::string_view>
+    [[nodiscard]] std::pmr::vector<std::string_view> value_or_string_view(const V& default_value,
+        std::pmr::memory_resource* resource, const Column& column_0, const Columns&... column_v)
+    {
+        const std::size_t rows = pmr_impl::rows(column_0);
+        std::pmr::vector<std::string_view> out{ resource };
+        out.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+            out.emplace_back(pmr_impl::row(default_value, i, column_0, column_v...));
+        return out;
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,205 @@
+/**********************************************************************
+ * \file   value_or_project.h
+ * \brief  It contains the batch version of value_or with a projection
+ *         for each column, to convert the columns to the same unit
+ *         (grams and kilograms, currencies, offsets) in the same pass:
+ *         value_or_batch_projected(default_value, out, sources...)
+ *         where a source is a nullable_column, without projection, or
+ *         project_column(column, projection).
+ *         Only the projection of the column that supplies the value
+ *         of a row is applied, and the coalesced column is not
+ *         written before the projections: the block finds the
+ *         winning column of every row, then applies the projection of
+ *         each column to the rows it has won, with the path that
+ *         suits that projection:
+ *         the affine projections (value * scale + offset) are applied
+ *         to every row and kept with a select only where the column
+ *         has won, without branches, so the loop is vectorized;
+ *         the other projections are applied with a test on each row;
+ *         the columns without projection (or with std::identity) are
+ *         skipped.
+ *         The default value and the values of the columns without
+ *         projection are never transformed: -0.0 and the payloads of
+ *         the NaN are kept.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_project_H
+#define __value_or_project_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "value_or_batch.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Affine projection: value * scale + offset. It is recognized by
+     * value_or_batch_projected, that applies it without branches.
+     */
+    template<typename T>
+    struct affine
+    {
+        T scale = T{ 1 };
+        T offset = T{ 0 };
+
+        [[nodiscard]] constexpr T operator()(T value) const noexcept
+        {
+            return static_cast<T>(value * scale + offset);
+        }
+    };
+
+    /**
+     * Column with the projection to apply to its values.
+     */
+    template<typename T, typename Projection>
+    struct projected_column
+    {
+        nullable_column<T> column;
+        Projection projection;
+    };
+
+    /**
+     * It returns the column with the projection, a source of value_or_batch_projected.
+     *
+     * \param column Column of nullable values
+     * \param projection T projection(T), applied to the values of column
+     */
+    template<typename T, typename Projection>
+    requires std::convertible_to<std::invoke_result_t<const Projection&, T>, T>
+    [[nodiscard]] constexpr projected_column<T, Projection> project_column(const nullable_column<T>& column,
+        Projection projection)
+    {
+        return { column, std::move(projection) };
+    }
+
+
+    namespace project_impl
+    {
+        using value_or_batch_impl::block_rows;
+        using value_or_batch_impl::select;
+
+        template<typename Source>
+        struct source_traits;
+
+        template<typename T>
+        struct source_traits<nullable_column<T>>
+        {
+            using value_type = T;
+            static constexpr bool is_affine = false;
+            static constexpr bool is_identity = true;
+        };
+
+        template<typename T, typename Projection>
+        struct source_traits<projected_column<T, Projection>>
+        {
+            using value_type = T;
+            static constexpr bool is_affine = std::same_as<Projection, affine<T>>;
+            static constexpr bool is_identity = std::same_as<Projection, std::identity>;
+        };
+
+        template<typename T>
+        [[nodiscard]] constexpr const nullable_column<T>& column_of(const nullable_column<T>& source) noexcept
+        {
+            return source;
+        }
+
+        template<typename T, typename Projection>
+        [[nodiscard]] constexpr const nullable_column<T>& column_of(const projected_column<T, Projection>& source) noexcept
+        {
+            return source.column;
+        }
+
+        /**
+         * The winners of the rows are resolved once, then the projection of
+         * each column is applied to the rows won by the column: the affine
+         * projections are applied to all the rows and selected, the other
+         * ones are applied with a test on each row, the identities are
+         * skipped. The rows won by other columns enter the affine projection
+         * as 0, so the arithmetic on them cannot overflow.
+         */
+        template<typename T, typename... Sources>
+        constexpr void projected_block(const T& default_value, std::size_t begin, std::size_t rows,
+            T* acc, std::uint8_t* win, const Sources&... sources)
+        {
+            const std::array<const nullable_column<T>*, sizeof...(Sources)> columns{ &column_of(sources)... };
+            value_or_batch_impl::resolve_block<true>(default_value, columns, begin, rows, acc, win);
+
+            const auto apply = [&]<std::size_t K, typename Source>(std::integral_constant<std::size_t, K>, const Source& source)
+            {
+                if constexpr (source_traits<Source>::is_affine)
+                {
+                    const T scale = source.projection.scale;
+                    const T offset = source.projection.offset;
+                    for (std::size_t i = 0; i < rows; ++i)
+                    {
+                        const bool s = win[i] == K;
+                        const T value = select(s, acc[i], T{ 0 });
+                        acc[i] = select(s, static_cast<T>(value * scale + offset), acc[i]);
+                    }
+                }
+                else if constexpr (!source_traits<Source>::is_identity)
+                {
+                    for (std::size_t i = 0; i < rows; ++i)
+                    {
+                        if (win[i] == K)
+                            acc[i] = static_cast<T>(std::invoke(source.projection, acc[i]));
+                    }
+                }
+            };
+            [&]<std::size_t... K>(std::index_sequence<K...>)
+            {
+                (apply(std::integral_constant<std::size_t, K>{}, sources), ...);
+            }(std::index_sequence_for<Sources...>{});
+        }
+    }
+
+
+    /**
+     * It applies value_or to every row of the sources, with the projection of
+     * each source: out[i] is projection_k(value) of the first source k with a
+     * value at the row i, default_value if no source has a value.
+     * All the sources must have at least out.size() rows.
+     *
+     * \param default_value Value to use for the rows where all the sources are null, not projected
+     * \param out Coalesced column
+     * \param source_0 First source to check, a nullable_column or a project_column
+     * \param ...source_v Next sources to check
+     */
+    template<typename Source, typename... Sources>
+    requires std::is_trivially_copyable_v<typename project_impl::source_traits<Source>::value_type>
+        && (std::same_as<typename project_impl::source_traits<Source>::value_type,
+            typename project_impl::source_traits<Sources>::value_type> && ...)
+    constexpr void value_or_batch_projected(const typename project_impl::source_traits<Source>::value_type& default_value,
+        std::span<typename project_impl::source_traits<Source>::value_type> out,
+        const Source& source_0, const Sources&... source_v)
+    {
+        using T = typename project_impl::source_traits<Source>::value_type;
+        static_assert(1 + sizeof...(Sources) <= value_or_batch_impl::max_columns, "too many columns");
+
+        T acc[project_impl::block_rows];
+        std::uint8_t win[project_impl::block_rows];
+        for (std::size_t begin = 0; begin < out.size(); begin += project_impl::block_rows)
+        {
+            const std::size_t rows = std::min(project_impl::block_rows, out.size() - begin);
+            project_impl::projected_block(default_value, begin, rows, acc, win, source_0, source_v...);
+            std::copy_n(acc, rows, out.data() + begin);
+        }
+    }
+
+} // end namespace s4
+
+#endif
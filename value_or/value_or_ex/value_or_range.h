@@ -0,0 +1,250 @@
+/**********************************************************************
+ * \file   value_or_range.h
+ * \brief  It contains the functions:
+ *         value_or_range(T&& default_value, Range&& to_test_r) and
+ *         value_or_range_index(Range&& to_test_r).
+ *         They are the runtime version of value_or: the values to
+ *         test are the elements of a range, whose length is not
+ *         known at compile time (a std::vector<std::optional<T>>,
+ *         a std::span<T*>, ...).
+ *         For contiguous ranges of std::optional or of raw pointers
+ *         the first element with a value is searched a block at a
+ *         time, without a branch for each element.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_range_H
+#define __value_or_range_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S4_VALUE_OR_SSE2 1
+#endif
+
+#include "value_or.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+    /**
+     * Index returned by value_or_range_index when no element has a value.
+     */
+    inline constexpr std::size_t value_or_npos = static_cast<std::size_t>(-1);
+
+
+    namespace value_or_range_impl
+    {
+        template<typename T>
+        struct is_optional : std::false_type {};
+
+        template<typename T>
+        struct is_optional<std::optional<T>> : std::true_type {};
+
+        template<typename R>
+        using element_t = std::remove_cv_t<std::ranges::range_value_t<R>>;
+
+        /**
+         * Concept that defines a contiguous range of std::optional or of raw
+         * pointers, the ranges that have the block scan.
+         */
+        template<typename R>
+        concept block_scannable = std::ranges::contiguous_range<R>
+            && std::ranges::sized_range<R>
+            && (is_optional<element_t<R>>::value || std::is_pointer_v<element_t<R>>);
+
+        // number of elements tested by each step of the block scan
+        inline constexpr std::size_t block_size = 32;
+
+
+        /**
+         * It returns the index of the first element of the block [p, p + n)
+         * with a value. It is called only for the block that contains it,
+         * therefore the branch is taken only once.
+         */
+        template<typename HT>
+        [[nodiscard]] constexpr std::size_t locate(const HT* p, std::size_t n) noexcept
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (!!p[i])
+                    return i;
+            }
+            return value_or_npos;
+        }
+
+
+        /**
+         * Block scan of optionals: the engaged flags of a block are copied,
+         * without branches, in a byte array, then the array is tested
+         * 8 flags at a time.
+         */
+        template<typename T>
+        [[nodiscard]] std::size_t first_index(const std::optional<T>* p, std::size_t n) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + block_size <= n; i += block_size)
+            {
+                unsigned char flags[block_size];
+                for (std::size_t j = 0; j < block_size; ++j)
+                    flags[j] = static_cast<unsigned char>(p[i + j].has_value());
+
+                for (std::size_t j = 0; j < block_size; j += sizeof(std::uint64_t))
+                {
+                    std::uint64_t w;
+                    std::memcpy(&w, flags + j, sizeof(w));
+                    if (w != 0)
+                    {
+                        if constexpr (std::endian::native == std::endian::little)
+                            return i + j + static_cast<std::size_t>(std::countr_zero(w)) / 8;
+                        else
+                            return i + j + static_cast<std::size_t>(std::countl_zero(w)) / 8;
+                    }
+                }
+            }
+
+            const std::size_t r = locate(p + i, n - i);
+            return r == value_or_npos ? r : i + r;
+        }
+
+
+        /**
+         * Block scan of raw pointers: the pointer words of a block are OR-ed
+         * together (with SSE2 when it is available) and only the block with
+         * a not null pointer is scanned element by element.
+         */
+        template<typename T>
+        [[nodiscard]] std::size_t first_index(T* const* p, std::size_t n) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + block_size <= n; i += block_size)
+            {
+#ifdef S4_VALUE_OR_SSE2
+                constexpr std::size_t per_vector = sizeof(__m128i) / sizeof(T*);
+                __m128i acc = _mm_setzero_si128();
+                for (std::size_t j = 0; j < block_size; j += per_vector)
+                    acc = _mm_or_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + j)));
+                const bool found = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF;
+#else
+                std::uintptr_t acc = 0;
+                for (std::size_t j = 0; j < block_size; ++j)
+                    acc |= reinterpret_cast<std::uintptr_t>(p[i + j]);
+                const bool found = acc != 0;
+#endif
+                if (found)
+                    return i + locate(p + i, block_size);
+            }
+
+            const std::size_t r = locate(p + i, n - i);
+            return r == value_or_npos ? r : i + r;
+        }
+
+
+        /**
+         * It returns an iterator to the first element of to_test_r with a value,
+         * or the end of to_test_r if there is not.
+         */
+        template<std::ranges::input_range R>
+        [[nodiscard]] constexpr std::ranges::iterator_t<R> first_with_value(R& to_test_r)
+        {
+            if constexpr (block_scannable<R>)
+            {
+                if (!std::is_constant_evaluated())
+                {
+                    const std::size_t n = std::ranges::size(to_test_r);
+                    const std::size_t i = first_index(std::ranges::data(to_test_r), n);
+                    return std::ranges::next(std::ranges::begin(to_test_r),
+                        static_cast<std::ranges::range_difference_t<R>>(i == value_or_npos ? n : i));
+                }
+            }
+
+            auto it = std::ranges::begin(to_test_r);
+            for (; it != std::ranges::end(to_test_r); ++it)
+            {
+                if (!!*it)
+                    break;
+            }
+            return it;
+        }
+    }
+
+
+    /**
+     * It returns the index of the first element of to_test_r that has a value.
+     *
+     * \param to_test_r Range of values to check, they must have the operators * and !
+     * \return The index of the first element of to_test_r with a value,
+     *         value_or_npos if no element has a value.
+     */
+    template<std::ranges::input_range Range>
+    requires requires(std::ranges::range_reference_t<Range> value_holder) { {!value_holder}; }
+    [[nodiscard]] constexpr std::size_t value_or_range_index(Range&& to_test_r)
+    {
+        if constexpr (value_or_range_impl::block_scannable<Range>)
+        {
+            if (!std::is_constant_evaluated())
+                return value_or_range_impl::first_index(std::ranges::data(to_test_r), std::ranges::size(to_test_r));
+        }
+
+        // the index is counted in the scan: an input range can be traversed once
+        std::size_t i = 0;
+        for (auto it = std::ranges::begin(to_test_r); it != std::ranges::end(to_test_r); ++it, ++i)
+        {
+            if (!!*it)
+                return i;
+        }
+        return value_or_npos;
+    }
+
+    /**
+     * It looks for the first element of to_test_r with a value. If it does
+     * not find it, then value_or_range returns default_value.
+     * The return type follows the rules of value_or: it is a reference of
+     * DefaultType.
+     *
+     * \param default_value Value to return if all the elements of to_test_r are null
+     * \param to_test_r Range of values to check
+     * \return The value of the first element of to_test_r not null. If all the
+     *         elements are null then value_or_range returns default_value.
+     */
+    template<typename DefaultType, std::ranges::input_range Range>
+    requires (!std::invocable<DefaultType>)
+        && value_or_value_holder<std::ranges::range_reference_t<Range>, DefaultType>
+        && requires(std::ranges::range_reference_t<Range> value_holder) { {!value_holder}; }
+    [[nodiscard]] constexpr DefaultType value_or_range(DefaultType&& default_value, Range&& to_test_r)
+    {
+        const auto it = value_or_range_impl::first_with_value(to_test_r);
+        return it == std::ranges::end(to_test_r)
+            ? static_cast<DefaultType>(default_value)
+            : static_cast<DefaultType>(**it);
+    }
+
+    /**
+     * Specialized version of value_or_range: DefaultType is invocable, it is
+     * called only if all the elements of to_test_r are null.
+     */
+    template<typename DefaultType, std::ranges::input_range Range>
+    requires std::invocable<DefaultType>
+        && value_or_value_holder<std::ranges::range_reference_t<Range>, DefaultType>
+        && requires(std::ranges::range_reference_t<Range> value_holder) { {!value_holder}; }
+    [[nodiscard]] constexpr std::invoke_result_t<DefaultType> value_or_range(DefaultType&& default_value, Range&& to_test_r)
+    {
+        const auto it = value_or_range_impl::first_with_value(to_test_r);
+        return it == std::ranges::end(to_test_r)
+            ? default_value()
+            : static_cast<std::invoke_result_t<DefaultType>>(**it);
+    }
+
+} // end namespace s4
+
+#endif
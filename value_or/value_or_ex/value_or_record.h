@@ -0,0 +1,214 @@
+/**********************************************************************
+ * \file   value_or_record.h
+ * \brief  It contains the class nullable_struct<Fields...>: a record
+ *         of nullable fields, like a struct of std::optional, where
+ *         the values are stored together and the presence flags are
+ *         the bits of one word, so there is no flag and no padding
+ *         for each field:
+ *         nullable_struct<int, int> is 12 bytes, a struct of two
+ *         std::optional<int> is 16; with 4 fields 20 bytes and 32.
+ *         field<I>() returns a value holder of the field I, that
+ *         can be passed to value_or.
+ *         value_or_record(default_record, records...) coalesces each
+ *         field, testing all the missing fields of a record with one
+ *         mask operation.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_record_H
+#define __value_or_record_H
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace record_impl
+    {
+        /**
+         * Smallest unsigned type with at least Bits bits.
+         */
+        template<std::size_t Bits>
+        using mask_t = std::conditional_t<(Bits <= 8), std::uint8_t,
+            std::conditional_t<(Bits <= 16), std::uint16_t,
+            std::conditional_t<(Bits <= 32), std::uint32_t, std::uint64_t>>>;
+    }
+
+
+    /**
+     * Record of nullable fields of types Fields. The values of the fields
+     * without value are default constructed.
+     */
+    template<std::default_initializable... Fields>
+    requires (sizeof...(Fields) > 0 && sizeof...(Fields) <= 64)
+    class nullable_struct
+    {
+    public:
+        using mask_type = record_impl::mask_t<sizeof...(Fields)>;
+
+        template<std::size_t I>
+        using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+        static constexpr std::size_t field_count = sizeof...(Fields);
+
+        // mask of all the fields
+        static constexpr mask_type all_fields = static_cast<mask_type>(static_cast<mask_type>(~mask_type{ 0 }) >> (8 * sizeof(mask_type) - field_count));
+
+        /**
+         * Value holder of the field I of a record: it can be passed to value_or.
+         */
+        template<std::size_t I>
+        class field_holder
+        {
+        public:
+            explicit constexpr field_holder(const nullable_struct& record) noexcept
+                : _record{ &record }
+            {}
+
+            [[nodiscard]] constexpr bool operator!() const noexcept
+            {
+                return !_record->template has<I>();
+            }
+
+            [[nodiscard]] constexpr const field_type<I>& operator*() const noexcept
+            {
+                return _record->template value<I>();
+            }
+
+        private:
+            const nullable_struct* _record;
+        };
+
+        /**
+         * It returns the mask of the fields I...: the bits to test with has_all.
+         */
+        template<std::size_t... I>
+        [[nodiscard]] static constexpr mask_type mask_of() noexcept
+        {
+            static_assert(((I < field_count) && ...));
+            return static_cast<mask_type>(((mask_type{ 1 } << I) | ... | mask_type{ 0 }));
+        }
+
+        constexpr nullable_struct() = default;
+
+        /**
+         * It builds a record where all the fields have a value.
+         */
+        explicit constexpr nullable_struct(const Fields&... values)
+            : _values{ values... }, _present{ all_fields }
+        {}
+
+        template<std::size_t I>
+        [[nodiscard]] constexpr bool has() const noexcept
+        {
+            return (_present & mask_of<I>()) != 0;
+        }
+
+        /**
+         * It returns true if all the fields of mask have a value.
+         */
+        [[nodiscard]] constexpr bool has_all(mask_type mask) const noexcept
+        {
+            return (_present & mask) == mask;
+        }
+
+        [[nodiscard]] constexpr mask_type mask() const noexcept
+        {
+            return _present;
+        }
+
+        /**
+         * It returns the value of the field I, it must have a value.
+         */
+        template<std::size_t I>
+        [[nodiscard]] constexpr const field_type<I>& value() const noexcept
+        {
+            return std::get<I>(_values);
+        }
+
+        template<std::size_t I>
+        [[nodiscard]] constexpr field_holder<I> field() const noexcept
+        {
+            return field_holder<I>{ *this };
+        }
+
+        template<std::size_t I, typename V>
+        constexpr void set(V&& v)
+        {
+            std::get<I>(_values) = std::forward<V>(v);
+            _present = static_cast<mask_type>(_present | mask_of<I>());
+        }
+
+        template<std::size_t I>
+        constexpr void reset()
+        {
+            std::get<I>(_values) = field_type<I>{};
+            _present = static_cast<mask_type>(_present & ~mask_of<I>());
+        }
+
+        /**
+         * It copies from other the fields of mask that have a value in other.
+         */
+        constexpr void assign(const nullable_struct& other, mask_type mask)
+        {
+            mask = static_cast<mask_type>(mask & other._present);
+            assign_fields(other, mask, std::index_sequence_for<Fields...>{});
+            _present = static_cast<mask_type>(_present | mask);
+        }
+
+        bool operator==(const nullable_struct&) const = default;
+
+    private:
+        template<std::size_t... I>
+        constexpr void assign_fields(const nullable_struct& other, mask_type mask, std::index_sequence<I...>)
+        {
+            ((mask & mask_of<I>() ? (void)(std::get<I>(_values) = std::get<I>(other._values)) : (void)0), ...);
+        }
+
+        std::tuple<Fields...> _values;
+        mask_type _present = 0;
+    };
+
+
+    /**
+     * Coalesce of records, field by field: each field of the result has the
+     * value of the first record that has it, or the value of default_record
+     * if no record has it (it can be null).
+     * The fields still missing are a mask: a record is tested with one and,
+     * and the loop stops as soon as all the fields have a value.
+     *
+     * \param default_record Values of the fields that no record has
+     * \param ...records Records to check, in order
+     * \return The coalesced record
+     */
+    template<typename... Fields, std::same_as<nullable_struct<Fields...>>... Records>
+    [[nodiscard]] constexpr nullable_struct<Fields...> value_or_record(const nullable_struct<Fields...>& default_record,
+        const Records&... records)
+    {
+        using record = nullable_struct<Fields...>;
+        using mask_type = typename record::mask_type;
+
+        record r;
+        mask_type missing = record::all_fields;
+        const record* to_test[] = { &records..., nullptr };
+        for (std::size_t i = 0; i < sizeof...(Records) && missing != 0; ++i)
+        {
+            const mask_type found = static_cast<mask_type>(to_test[i]->mask() & missing);
+            r.assign(*to_test[i], found);
+            missing = static_cast<mask_type>(missing & ~found);
+        }
+        r.assign(default_record, missing);
+        return r;
+    }
+
+} // end namespace s4
+
+#endif
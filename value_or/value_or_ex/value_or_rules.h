@@ -0,0 +1,417 @@
+/**********************************************************************
+ * \file   value_or_rules.h
+ * \brief  It contains coalesce_rule<T>: a coalesce rule written as
+ *         text, for example read from a configuration file, compiled
+ *         at runtime and executed over columns of nullable values.
+ *
+ *         rule     := "coalesce" "(" term { "," term } ")" | term
+ *         term     := sum [ "if" column { "and" column } ]
+ *         sum      := product { ("+" | "-") constant }
+ *         product  := operand { "*" number }
+ *         constant := number { "*" number }
+ *         operand  := column | number
+ *
+ *         "*" binds tighter than "+" and "-": B + 32 * 1.8 is
+ *         B + (32 * 1.8), the constant is folded by compile.
+ *
+ *         coalesce(A, B * 1000, C if D, 0): A, else B scaled by 1000,
+ *         else C if D has a value, else 0. A number always has a
+ *         value, the terms after it are never used; the rows where no
+ *         term has a value get the default value of run.
+ *
+ *         compile translates the rule in a list of instructions that
+ *         work on a block of rows, so each instruction is dispatched
+ *         once for block_rows rows and its loop is vectorized; the
+ *         interpretation costs a switch every few hundreds rows.
+ *         A block stops when all its rows have a value.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_rules_H
+#define __value_or_rules_H
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "value_or_batch.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace rules_impl
+    {
+        using value_or_batch_impl::block_rows;
+        using value_or_batch_impl::select;
+
+        enum class opcode : std::uint8_t
+        {
+            load,       // term = column, term_valid = valid of column
+            load_const, // term = constant, term_valid = 1
+            mul,        // term *= constant
+            add,        // term += constant
+            require,    // term_valid &= valid of column
+            take,       // the rows without a value and with term_valid take term
+        };
+
+        template<typename T>
+        struct instruction
+        {
+            opcode op;
+            std::uint16_t column = 0;
+            T constant{};
+        };
+
+        /**
+         * Arithmetic of the terms: it is done also on the values of the null
+         * rows, so the signed integers use the unsigned arithmetic, that
+         * cannot overflow.
+         */
+        template<typename T>
+        [[nodiscard]] constexpr T mul(T a, T b) noexcept
+        {
+            if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                using U = std::make_unsigned_t<T>;
+                return static_cast<T>(static_cast<U>(static_cast<U>(a) * static_cast<U>(b)));
+            }
+            else
+            {
+                return static_cast<T>(a * b);
+            }
+        }
+
+        template<typename T>
+        [[nodiscard]] constexpr T add(T a, T b) noexcept
+        {
+            if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                using U = std::make_unsigned_t<T>;
+                return static_cast<T>(static_cast<U>(static_cast<U>(a) + static_cast<U>(b)));
+            }
+            else
+            {
+                return static_cast<T>(a + b);
+            }
+        }
+
+        /**
+         * Recursive descent parser of a rule, it appends the instructions to code.
+         */
+        template<typename T>
+        class parser
+        {
+        public:
+            parser(std::string_view text, std::span<const std::string_view> columns, std::vector<instruction<T>>& code)
+                : _text{ text }, _columns{ columns }, _code{ code }
+            {}
+
+            void rule()
+            {
+                skip_spaces();
+                const std::size_t start = _pos;
+                if (identifier() == "coalesce" && (skip_spaces(), accept('(')))
+                {
+                    term();
+                    while (accept(','))
+                        term();
+                    expect(')');
+                }
+                else
+                {
+                    _pos = start;
+                    term();
+                }
+                skip_spaces();
+                if (_pos != _text.size())
+                    fail("unexpected text");
+            }
+
+        private:
+            void term()
+            {
+                sum();
+                if (keyword("if"))
+                {
+                    do
+                        _code.push_back({ opcode::require, column(), T{} });
+                    while (keyword("and"));
+                }
+                _code.push_back({ opcode::take, 0, T{} });
+            }
+
+            void sum()
+            {
+                product();
+                for (;;)
+                {
+                    if (accept('+'))
+                        _code.push_back({ opcode::add, 0, constant() });
+                    else if (accept('-'))
+                        _code.push_back({ opcode::add, 0, mul(constant(), static_cast<T>(-1)) });
+                    else
+                        break;
+                }
+            }
+
+            void product()
+            {
+                skip_spaces();
+                if (number_follows())
+                    _code.push_back({ opcode::load_const, 0, number() });
+                else
+                    _code.push_back({ opcode::load, column(), T{} });
+
+                while (accept('*'))
+                    _code.push_back({ opcode::mul, 0, number() });
+            }
+
+            // product of numbers, evaluated by the parser
+            [[nodiscard]] T constant()
+            {
+                T value = number();
+                while (accept('*'))
+                    value = mul(value, number());
+                return value;
+            }
+
+            [[nodiscard]] std::uint16_t column()
+            {
+                skip_spaces();
+                const std::size_t start = _pos;
+                const std::string_view name = identifier();
+                if (name.empty())
+                    fail("column expected");
+                const auto it = std::find(_columns.begin(), _columns.end(), name);
+                if (it == _columns.end())
+                {
+                    _pos = start;
+                    fail("unknown column '" + std::string{ name } + "'");
+                }
+                return static_cast<std::uint16_t>(it - _columns.begin());
+            }
+
+            [[nodiscard]] T number()
+            {
+                skip_spaces();
+                const char* first = _text.data() + _pos;
+                const char* last = _text.data() + _text.size();
+                T value{};
+                const std::from_chars_result r = std::from_chars(first, last, value);
+                if (r.ec != std::errc{})
+                    fail("number expected");
+                _pos += static_cast<std::size_t>(r.ptr - first);
+                return value;
+            }
+
+            [[nodiscard]] bool number_follows() const noexcept
+            {
+                return _pos < _text.size()
+                    && (std::isdigit(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '-' || _text[_pos] == '.');
+            }
+
+            [[nodiscard]] std::string_view identifier() noexcept
+            {
+                const std::size_t start = _pos;
+                while (_pos < _text.size()
+                    && (std::isalnum(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_'
+                        || (_pos > start && _text[_pos] == '.')))
+                    ++_pos;
+                if (start < _pos && std::isdigit(static_cast<unsigned char>(_text[start])))
+                {
+                    _pos = start;
+                    return {};
+                }
+                return _text.substr(start, _pos - start);
+            }
+
+            [[nodiscard]] bool keyword(std::string_view word)
+            {
+                skip_spaces();
+                const std::size_t start = _pos;
+                if (identifier() == word)
+                    return true;
+                _pos = start;
+                return false;
+            }
+
+            [[nodiscard]] bool accept(char c) noexcept
+            {
+                skip_spaces();
+                if (_pos < _text.size() && _text[_pos] == c)
+                {
+                    ++_pos;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(char c)
+            {
+                if (!accept(c))
+                    fail(std::string{ "'" } + c + "' expected");
+            }
+
+            void skip_spaces() noexcept
+            {
+                while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos])))
+                    ++_pos;
+            }
+
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::invalid_argument("coalesce_rule: " + message + " at " + std::to_string(_pos)
+                    + " in \"" + std::string{ _text } + "\"");
+            }
+
+            std::string_view _text;
+            std::span<const std::string_view> _columns;
+            std::vector<instruction<T>>& _code;
+            std::size_t _pos = 0;
+        };
+    }
+
+
+    /**
+     * Coalesce rule compiled from its text, for columns of type T.
+     */
+    template<typename T>
+    requires std::is_arithmetic_v<T>
+    class coalesce_rule
+    {
+    public:
+        /**
+         * It compiles the rule text. The columns of the rule are the names of
+         * columns, their indexes are the indexes of the columns passed to run.
+         *
+         * \throw std::invalid_argument if the text is not a valid rule
+         */
+        [[nodiscard]] static coalesce_rule compile(std::string_view text, std::span<const std::string_view> columns)
+        {
+            if (columns.size() > 0xFFFF)
+                throw std::invalid_argument("coalesce_rule: too many columns");
+
+            coalesce_rule r;
+            rules_impl::parser<T>{ text, columns, r._code }.rule();
+            r._columns = columns.size();
+            return r;
+        }
+
+        /**
+         * It applies the rule to every row of the columns, out[i] is the value
+         * of the first term of the rule with a value at the row i,
+         * default_value if no term has a value.
+         * All the columns must have at least out.size() rows.
+         *
+         * \param default_value Value of the rows where no term has a value
+         * \param out Coalesced column
+         * \param columns Columns of the rule, in the order of the names passed to compile
+         * \throw std::invalid_argument if columns has less columns than the names passed to compile
+         */
+        void run(const T& default_value, std::span<T> out, std::span<const nullable_column<T>> columns) const
+        {
+            if (columns.size() < _columns)
+                throw std::invalid_argument("coalesce_rule: missing columns");
+
+            T acc[rules_impl::block_rows];
+            T term[rules_impl::block_rows];
+            std::uint8_t done[rules_impl::block_rows];
+            std::uint8_t term_valid[rules_impl::block_rows];
+
+            for (std::size_t begin = 0; begin < out.size(); begin += rules_impl::block_rows)
+            {
+                const std::size_t rows = std::min(rules_impl::block_rows, out.size() - begin);
+                for (std::size_t i = 0; i < rows; ++i)
+                {
+                    acc[i] = default_value;
+                    done[i] = 0;
+                }
+
+                for (const rules_impl::instruction<T>& ins : _code)
+                {
+                    if (execute(ins, columns, begin, rows, acc, term, done, term_valid))
+                        break;
+                }
+                std::copy_n(acc, rows, out.data() + begin);
+            }
+        }
+
+        /**
+         * It returns the number of instructions of the compiled rule.
+         */
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return _code.size();
+        }
+
+    private:
+        coalesce_rule() = default;
+
+        /**
+         * It executes ins on the rows of the block, it returns true if all the
+         * rows have a value and the next instructions can be skipped.
+         */
+        static bool execute(const rules_impl::instruction<T>& ins, std::span<const nullable_column<T>> columns,
+            std::size_t begin, std::size_t rows, T* acc, T* term, std::uint8_t* done, std::uint8_t* term_valid) noexcept
+        {
+            using rules_impl::opcode;
+
+            switch (ins.op)
+            {
+            case opcode::load:
+                std::copy_n(columns[ins.column].values.data() + begin, rows, term);
+                std::copy_n(columns[ins.column].valid.data() + begin, rows, term_valid);
+                break;
+            case opcode::load_const:
+                std::fill_n(term, rows, ins.constant);
+                std::fill_n(term_valid, rows, std::uint8_t{ 1 });
+                break;
+            case opcode::mul:
+                for (std::size_t i = 0; i < rows; ++i)
+                    term[i] = rules_impl::mul(term[i], ins.constant);
+                break;
+            case opcode::add:
+                for (std::size_t i = 0; i < rows; ++i)
+                    term[i] = rules_impl::add(term[i], ins.constant);
+                break;
+            case opcode::require:
+            {
+                const std::uint8_t* valid = columns[ins.column].valid.data() + begin;
+                for (std::size_t i = 0; i < rows; ++i)
+                    term_valid[i] = static_cast<std::uint8_t>((term_valid[i] != 0) & (valid[i] != 0));
+                break;
+            }
+            case opcode::take:
+            {
+                std::uint8_t all = 1;
+                for (std::size_t i = 0; i < rows; ++i)
+                {
+                    const bool s = (term_valid[i] != 0) & (done[i] == 0);
+                    acc[i] = rules_impl::select(s, term[i], acc[i]);
+                    done[i] = static_cast<std::uint8_t>(done[i] | (term_valid[i] != 0));
+                    all &= done[i];
+                }
+                return all != 0;
+            }
+            }
+            return false;
+        }
+
+        std::vector<rules_impl::instruction<T>> _code;
+        std::size_t _columns = 0;
+    };
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,275 @@
+/**********************************************************************
+ * \file   value_or_settings.h
+ * \brief  It contains the value holders env<T>("NAME") and
+ *         arg<T>("--name"), for the settings read from the
+ *         environment variables and from the command line:
+ *         value_or(8080, arg<int>("--port"), env<int>("PORT")).
+ *         The environment and the command line are copied once in
+ *         a snapshot with a hash index, so a lookup does not scan
+ *         environ. A holder looks for its value and parses it with
+ *         std::from_chars only when value_or tests it, that is only
+ *         if no value before it has been found; the result is cached.
+ *         A value that cannot be parsed is null.
+ *         The holders copy their name. The values read as
+ *         std::string_view refer to the snapshot: they, and the
+ *         holders that cached them, are invalidated by
+ *         snapshot_environment() (env) and set_command_line() (arg);
+ *         read them as std::string to keep them.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_settings_H
+#define __value_or_settings_H
+
+#include <charconv>
+#include <concepts>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+extern "C" char** environ;
+#endif
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Snapshot of name-value pairs with a hash index. The strings are copied,
+     * so the snapshot does not depend on the memory of environ or argv.
+     */
+    class settings_snapshot
+    {
+    public:
+        settings_snapshot() = default;
+        settings_snapshot(const settings_snapshot&) = delete;
+        settings_snapshot& operator=(const settings_snapshot&) = delete;
+        settings_snapshot(settings_snapshot&&) = default;
+        settings_snapshot& operator=(settings_snapshot&&) = default;
+
+        /**
+         * It builds the snapshot of an environment: a null terminated array of
+         * "NAME=value" strings, like environ.
+         */
+        [[nodiscard]] static settings_snapshot from_environment(const char* const* envp)
+        {
+            settings_snapshot r;
+            for (; envp != nullptr && *envp != nullptr; ++envp)
+                r._storage.emplace_back(*envp);
+
+            r._index.reserve(r._storage.size());
+            for (const std::string& s : r._storage)
+            {
+                const std::string_view entry = s;
+                const std::size_t equal = entry.find('=');
+                if (equal != std::string_view::npos)
+                    r._index.insert_or_assign(entry.substr(0, equal), entry.substr(equal + 1));
+            }
+            return r;
+        }
+
+        /**
+         * It builds the snapshot of a command line: "--name=value" and "--name value"
+         * give value to "--name", a "--name" not followed by a value gives it an
+         * empty value (a flag). argv[0] and the other arguments are ignored.
+         * If an argument is repeated the last one wins.
+         */
+        [[nodiscard]] static settings_snapshot from_command_line(int argc, const char* const* argv)
+        {
+            settings_snapshot r;
+            for (int i = 1; i < argc; ++i)
+                r._storage.emplace_back(argv[i]);
+
+            const auto is_name = [](std::string_view s) { return s.size() > 2 && s.starts_with("--"); };
+            for (std::size_t i = 0; i < r._storage.size(); ++i)
+            {
+                const std::string_view token = r._storage[i];
+                if (!is_name(token))
+                    continue;
+
+                const std::size_t equal = token.find('=');
+                if (equal != std::string_view::npos)
+                    r._index.insert_or_assign(token.substr(0, equal), token.substr(equal + 1));
+                else if (i + 1 < r._storage.size() && !is_name(r._storage[i + 1]))
+                    r._index.insert_or_assign(token, std::string_view{ r._storage[++i] });
+                else
+                    r._index.insert_or_assign(token, std::string_view{});
+            }
+            return r;
+        }
+
+        /**
+         * It returns the value of name, std::nullopt if there is not.
+         */
+        [[nodiscard]] std::optional<std::string_view> find(std::string_view name) const
+        {
+            const auto it = _index.find(name);
+            if (it == _index.end())
+                return std::nullopt;
+            return it->second;
+        }
+
+    private:
+        // the index refers to the strings of _storage: the move of the vector
+        // keeps the buffers of the strings
+        std::vector<std::string> _storage;
+        std::unordered_map<std::string_view, std::string_view> _index;
+    };
+
+
+    namespace settings_impl
+    {
+        inline const char* const* process_environment() noexcept
+        {
+#if defined(_WIN32)
+            return _environ;
+#else
+            return environ;
+#endif
+        }
+
+        // the snapshot of the environment is taken by the first call
+        inline std::unique_ptr<settings_snapshot>& environment_ptr()
+        {
+            static std::unique_ptr<settings_snapshot> snapshot = std::make_unique<settings_snapshot>(
+                settings_snapshot::from_environment(process_environment()));
+            return snapshot;
+        }
+
+        inline std::unique_ptr<settings_snapshot>& command_line_ptr()
+        {
+            static std::unique_ptr<settings_snapshot> snapshot = std::make_unique<settings_snapshot>();
+            return snapshot;
+        }
+
+        inline const settings_snapshot& environment()
+        {
+            return *environment_ptr();
+        }
+
+        inline const settings_snapshot& command_line()
+        {
+            return *command_line_ptr();
+        }
+
+        /**
+         * It parses text as a T: std::from_chars for the numbers, the whole text
+         * must be used; 1/0, true/false, yes/no, on/off for bool, and the empty
+         * text is true (a flag); no parsing for the strings.
+         */
+        template<typename T>
+        [[nodiscard]] std::optional<T> parse(std::string_view text)
+        {
+            if constexpr (std::same_as<T, std::string_view> || std::same_as<T, std::string>)
+            {
+                return T{ text };
+            }
+            else if constexpr (std::same_as<T, bool>)
+            {
+                if (text.empty() || text == "1" || text == "true" || text == "yes" || text == "on")
+                    return true;
+                if (text == "0" || text == "false" || text == "no" || text == "off")
+                    return false;
+                return std::nullopt;
+            }
+            else
+            {
+                static_assert(std::is_arithmetic_v<T>, "env and arg support strings, bool and numbers");
+                T value{};
+                const char* end = text.data() + text.size();
+                const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+                if (ec != std::errc{} || ptr != end)
+                    return std::nullopt;
+                return value;
+            }
+        }
+
+        /**
+         * Value holder of a setting of the snapshot returned by Snapshot().
+         * operator! looks for the value and parses it the first time.
+         * The name is copied, so it can be a temporary string.
+         */
+        template<typename T, const settings_snapshot& (*Snapshot)()>
+        class setting
+        {
+        public:
+            explicit setting(std::string_view name)
+                : _name{ name }
+            {}
+
+            [[nodiscard]] bool operator!() const
+            {
+                if (!_resolved)
+                {
+                    if (const auto text = Snapshot().find(_name))
+                        _value = parse<T>(*text);
+                    _resolved = true;
+                }
+                return !_value;
+            }
+
+            /**
+             * It returns the parsed value, operator! must have returned false.
+             */
+            [[nodiscard]] const T& operator*() const
+            {
+                return *_value;
+            }
+
+        private:
+            std::string _name;
+            mutable std::optional<T> _value;
+            mutable bool _resolved = false;
+        };
+    }
+
+
+    /**
+     * Value holder of the environment variable name, parsed as a T (a number,
+     * bool, std::string or std::string_view).
+     */
+    template<typename T>
+    using env = settings_impl::setting<T, settings_impl::environment>;
+
+    /**
+     * Value holder of the command line argument name ("--name"), parsed as a T.
+     * The command line must be set with set_command_line.
+     */
+    template<typename T>
+    using arg = settings_impl::setting<T, settings_impl::command_line>;
+
+    /**
+     * It takes the snapshot of the command line used by arg. It must be called
+     * at the start, before any arg is tested. The std::string_view read by arg
+     * from the previous snapshot are invalidated.
+     */
+    inline void set_command_line(int argc, const char* const* argv)
+    {
+        settings_impl::command_line_ptr() = std::make_unique<settings_snapshot>(
+            settings_snapshot::from_command_line(argc, argv));
+    }
+
+    /**
+     * It takes again the snapshot of the environment used by env, after it has
+     * been changed. It must not be called while an env is tested. The
+     * std::string_view read by env from the previous snapshot, also the ones
+     * cached by env<std::string_view> holders, are invalidated.
+     */
+    inline void snapshot_environment()
+    {
+        settings_impl::environment_ptr() = std::make_unique<settings_snapshot>(
+            settings_snapshot::from_environment(settings_impl::process_environment()));
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,265 @@
+/**********************************************************************
+ * \file   value_or_sort.h
+ * \brief  It contains the sort of records by a coalesced key, like
+ *         value_or(default_key, r.primary_id, r.legacy_id):
+ *         value_or_sort_index(records, default_key, getters...)
+ *         evaluates the key of every record once, in an array of
+ *         keys and row indexes, and sorts the array instead of the
+ *         records, so the comparisons do not evaluate value_or and
+ *         the records are not moved.
+ *         The integral keys are sorted with a radix sort, the other
+ *         keys with a merge sort on several threads.
+ *         The sort is stable: the rows with the same key keep their
+ *         order, and unique_rows() returns the first row of each key.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_sort_H
+#define __value_or_sort_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "value_or.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Options of value_or_sort_index.
+     */
+    struct sort_options
+    {
+        // threads of the merge sort, 0 for std::thread::hardware_concurrency()
+        unsigned threads = 0;
+        // min rows sorted by each thread
+        std::size_t min_thread_rows = std::size_t{ 1 } << 14;
+    };
+
+
+    /**
+     * Records sorted by a coalesced key: keys[i] is the key of the record
+     * rows[i], keys is sorted.
+     */
+    template<typename K>
+    struct coalesced_index
+    {
+        std::vector<K> keys;
+        std::vector<std::size_t> rows;
+
+        /**
+         * It returns the rows of the records with the key key, in their order.
+         */
+        [[nodiscard]] std::span<const std::size_t> find(const K& key) const
+        {
+            const auto [first, last] = std::equal_range(keys.begin(), keys.end(), key);
+            return { rows.data() + (first - keys.begin()), static_cast<std::size_t>(last - first) };
+        }
+
+        /**
+         * It returns the first row of each key, in the order of the keys.
+         */
+        [[nodiscard]] std::vector<std::size_t> unique_rows() const
+        {
+            std::vector<std::size_t> r;
+            for (std::size_t i = 0; i < keys.size(); ++i)
+            {
+                if (i == 0 || keys[i - 1] < keys[i])
+                    r.push_back(rows[i]);
+            }
+            return r;
+        }
+    };
+
+
+    namespace sort_impl
+    {
+        template<typename K>
+        struct keyed_row
+        {
+            K key;
+            std::size_t row;
+        };
+
+        /**
+         * Unsigned key with the order of the integral key: the sign bit of the
+         * signed keys is flipped.
+         */
+        template<std::integral K>
+        [[nodiscard]] constexpr std::make_unsigned_t<K> radix_key(K key) noexcept
+        {
+            using U = std::make_unsigned_t<K>;
+            if constexpr (std::is_signed_v<K>)
+                return static_cast<U>(static_cast<U>(key) ^ (U{ 1 } << (8 * sizeof(U) - 1)));
+            else
+                return static_cast<U>(key);
+        }
+
+        /**
+         * Stable LSD radix sort, a byte at a time. The counts of all the bytes
+         * are computed in one pass, and the bytes where all the keys are in
+         * the same bucket are skipped.
+         */
+        template<std::integral K>
+        void radix_sort(std::vector<keyed_row<K>>& rows)
+        {
+            constexpr std::size_t bytes = sizeof(K);
+            std::vector<std::array<std::size_t, 256>> counts(bytes);
+            for (const keyed_row<K>& r : rows)
+            {
+                const auto u = radix_key(r.key);
+                for (std::size_t b = 0; b < bytes; ++b)
+                    ++counts[b][(u >> (8 * b)) & 0xFF];
+            }
+
+            std::vector<keyed_row<K>> buffer(rows.size());
+            for (std::size_t b = 0; b < bytes; ++b)
+            {
+                std::array<std::size_t, 256>& count = counts[b];
+                if (std::ranges::find(count, rows.size()) != count.end())
+                    continue;
+
+                std::size_t offset = 0;
+                for (std::size_t& c : count)
+                    offset += std::exchange(c, offset);
+                for (const keyed_row<K>& r : rows)
+                    buffer[count[(radix_key(r.key) >> (8 * b)) & 0xFF]++] = r;
+                rows.swap(buffer);
+            }
+        }
+
+        /**
+         * Stable merge sort on threads: the chunks are sorted in parallel,
+         * then merged in pairs, in parallel, until one chunk is left.
+         */
+        template<typename K>
+        void parallel_sort(std::vector<keyed_row<K>>& rows, const sort_options& options)
+        {
+            const auto less = [](const keyed_row<K>& a, const keyed_row<K>& b) { return a.key < b.key; };
+            const std::size_t hardware = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+            const std::size_t chunks = std::clamp<std::size_t>(rows.size() / std::max<std::size_t>(options.min_thread_rows, 1), 1, hardware);
+            if (chunks == 1)
+            {
+                std::stable_sort(rows.begin(), rows.end(), less);
+                return;
+            }
+
+            std::vector<std::size_t> bounds(chunks + 1);
+            for (std::size_t c = 0; c <= chunks; ++c)
+                bounds[c] = rows.size() * c / chunks;
+
+            {
+                std::vector<std::jthread> workers;
+                for (std::size_t c = 0; c < chunks; ++c)
+                {
+                    workers.emplace_back([&rows, &bounds, &less, c]()
+                    {
+                        std::stable_sort(rows.begin() + bounds[c], rows.begin() + bounds[c + 1], less);
+                    });
+                }
+            }
+
+            for (std::size_t width = 1; width < chunks; width *= 2)
+            {
+                std::vector<std::jthread> workers;
+                for (std::size_t c = 0; c + width < chunks; c += 2 * width)
+                {
+                    const auto first = rows.begin() + bounds[c];
+                    const auto middle = rows.begin() + bounds[c + width];
+                    const auto last = rows.begin() + bounds[std::min(c + 2 * width, chunks)];
+                    workers.emplace_back([first, middle, last, &less]()
+                    {
+                        std::inplace_merge(first, middle, last, less);
+                    });
+                }
+            }
+        }
+    }
+
+
+    /**
+     * It sorts the records by the key value_or(default_key, getters(record)...),
+     * without moving them: the keys are evaluated once for every record.
+     *
+     * \param options Threads of the sort of the keys that are not integral
+     * \param records Random access range of records
+     * \param default_key Key of the records where all the getters return null
+     * \param ...getters Invocables or pointers to members, getters(record) returns a value holder of the key
+     * \return The sorted keys and the row of each key
+     */
+    template<std::ranges::random_access_range Records, typename DT, typename... Getters>
+    requires (sizeof...(Getters) > 0)
+        && (std::invocable<const Getters&, std::ranges::range_reference_t<const Records&>> && ...)
+        && std::totally_ordered<std::remove_cvref_t<DT>>
+    [[nodiscard]] coalesced_index<std::remove_cvref_t<DT>> value_or_sort_index(const sort_options& options,
+        const Records& records, const DT& default_key, const Getters&... getters)
+    {
+        using K = std::remove_cvref_t<DT>;
+
+        const std::size_t size = static_cast<std::size_t>(std::ranges::size(records));
+        std::vector<sort_impl::keyed_row<K>> rows;
+        rows.reserve(size);
+        std::size_t row = 0;
+        for (const auto& record : records)
+            rows.push_back({ static_cast<K>(s4::value_or(default_key, std::invoke(getters, record)...)), row++ });
+
+        if constexpr (std::integral<K> && !std::same_as<K, bool>)
+            sort_impl::radix_sort(rows);
+        else
+            sort_impl::parallel_sort(rows, options);
+
+        coalesced_index<K> r;
+        r.keys.reserve(size);
+        r.rows.reserve(size);
+        for (sort_impl::keyed_row<K>& kr : rows)
+        {
+            r.keys.push_back(std::move(kr.key));
+            r.rows.push_back(kr.row);
+        }
+        return r;
+    }
+
+    /**
+     * value_or_sort_index with the default options.
+     */
+    template<std::ranges::random_access_range Records, typename DT, typename... Getters>
+    requires (sizeof...(Getters) > 0)
+        && (std::invocable<const Getters&, std::ranges::range_reference_t<const Records&>> && ...)
+        && std::totally_ordered<std::remove_cvref_t<DT>>
+    [[nodiscard]] coalesced_index<std::remove_cvref_t<DT>> value_or_sort_index(const Records& records,
+        const DT& default_key, const Getters&... getters)
+    {
+        return value_or_sort_index(sort_options{}, records, default_key, getters...);
+    }
+
+    /**
+     * It returns the permutation that sorts the records by the coalesced key:
+     * records[r[0]], records[r[1]], ... are sorted.
+     */
+    template<std::ranges::random_access_range Records, typename DT, typename... Getters>
+    requires (sizeof...(Getters) > 0)
+        && (std::invocable<const Getters&, std::ranges::range_reference_t<const Records&>> && ...)
+        && std::totally_ordered<std::remove_cvref_t<DT>>
+    [[nodiscard]] std::vector<std::size_t> value_or_sort_permutation(const Records& records,
+        const DT& default_key, const Getters&... getters)
+    {
+        return value_or_sort_index(sort_options{}, records, default_key, getters...).rows;
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,271 @@
+/**********************************************************************
+ * \file   value_or_stream.h
+ * \brief  It contains the streaming version of value_or:
+ *         coalesce_stream(default_value, streams...) reads the
+ *         streams, input ranges of value holders (std::generator,
+ *         views, containers, ...), in lockstep and returns the rows
+ *         value_or(default_value, streams[i]...) a chunk at a time:
+ *         next_chunk() returns a span of at most stream_chunk_rows
+ *         rows, valid until the next call, and an empty span at the
+ *         end of the shortest stream.
+ *         coalesce_stream_async(options, default_value, streams...)
+ *         reads the streams in a producer thread, that sends the
+ *         chunks to the consumer through a bounded queue: the memory
+ *         is at most queue_chunks + 1 chunks.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_stream_H
+#define __value_or_stream_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "value_or.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Default number of rows of a chunk.
+     */
+    inline constexpr std::size_t stream_chunk_rows = 1024;
+
+    /**
+     * Options of coalesce_stream_async.
+     */
+    struct stream_options
+    {
+        // max rows of a chunk
+        std::size_t chunk_rows = stream_chunk_rows;
+        // max chunks in the queue between the producer and the consumer
+        std::size_t queue_chunks = 4;
+    };
+
+
+    /**
+     * Coalescer of streams returned by coalesce_stream.
+     */
+    template<typename T, std::ranges::input_range... Views>
+    class stream_coalescer
+    {
+    public:
+        template<typename DT, typename... Streams>
+        explicit stream_coalescer(DT&& default_value, Streams&&... streams)
+            : _default{ std::forward<DT>(default_value) },
+              _views{ std::views::all(std::forward<Streams>(streams))... },
+              _its{ std::apply([](auto&... v) { return std::make_tuple(std::ranges::begin(v)...); }, _views) }
+        {}
+
+        stream_coalescer(const stream_coalescer&) = delete;
+        stream_coalescer& operator=(const stream_coalescer&) = delete;
+
+        /**
+         * It writes in out the next rows, until out is full or a stream ends.
+         *
+         * \return The number of rows written
+         */
+        std::size_t fill(std::span<T> out)
+        {
+            return std::apply([&](auto&... its)
+            {
+                return std::apply([&](auto&... views)
+                {
+                    std::size_t rows = 0;
+                    while (rows < out.size() && ((its != std::ranges::end(views)) && ...))
+                    {
+                        out[rows++] = static_cast<T>(s4::value_or(static_cast<const T&>(_default), *its...));
+                        (++its, ...);
+                    }
+                    return rows;
+                }, _views);
+            }, _its);
+        }
+
+        /**
+         * It returns the next chunk of at most max_rows rows, empty at the end of
+         * the shortest stream. The span is valid until the next call.
+         */
+        [[nodiscard]] std::span<const T> next_chunk(std::size_t max_rows = stream_chunk_rows)
+        {
+            _chunk.resize(max_rows);
+            return { _chunk.data(), fill(_chunk) };
+        }
+
+    private:
+        T _default;
+        std::tuple<Views...> _views;
+        std::tuple<std::ranges::iterator_t<Views>...> _its;
+        std::vector<T> _chunk;
+    };
+
+
+    /**
+     * Coalescer returned by coalesce_stream_async: a producer thread fills the
+     * chunks, next_chunk() takes them from the queue.
+     */
+    template<typename T>
+    class async_stream_coalescer
+    {
+    public:
+        /**
+         * fill(out) writes the next rows in out and returns their number, less
+         * than out.size() at the end.
+         */
+        template<typename Fill>
+        async_stream_coalescer(const stream_options& options, Fill fill)
+            : _free(std::max<std::size_t>(options.queue_chunks, 1), std::vector<T>(std::max<std::size_t>(options.chunk_rows, 1)))
+        {
+            _producer = std::jthread{ [this, fill = std::move(fill)](std::stop_token stop) mutable
+            {
+                produce(stop, fill);
+            } };
+        }
+
+        async_stream_coalescer(const async_stream_coalescer&) = delete;
+        async_stream_coalescer& operator=(const async_stream_coalescer&) = delete;
+
+        ~async_stream_coalescer()
+        {
+            _producer.request_stop();
+        }
+
+        /**
+         * It returns the next chunk, empty at the end of the shortest stream.
+         * The span is valid until the next call. It waits for the producer.
+         *
+         * \throw The exception thrown by the streams, if any
+         */
+        [[nodiscard]] std::span<const T> next_chunk()
+        {
+            std::unique_lock lock{ _mutex };
+            if (!_current.empty())
+            {
+                _free.push_back(std::move(_current));
+                _current.clear();
+                _changed.notify_all();
+            }
+
+            _changed.wait(lock, [this]() { return !_full.empty() || _done; });
+            if (_full.empty())
+            {
+                if (_error)
+                    std::rethrow_exception(std::exchange(_error, nullptr));
+                return {};
+            }
+            _current = std::move(_full.front().first);
+            const std::size_t rows = _full.front().second;
+            _full.pop_front();
+            _changed.notify_all();
+            return { _current.data(), rows };
+        }
+
+    private:
+        template<typename Fill>
+        void produce(std::stop_token stop, Fill& fill)
+        {
+            try
+            {
+                for (;;)
+                {
+                    std::vector<T> chunk;
+                    {
+                        std::unique_lock lock{ _mutex };
+                        if (!_changed.wait(lock, stop, [this]() { return !_free.empty(); }))
+                            break;
+                        chunk = std::move(_free.back());
+                        _free.pop_back();
+                    }
+
+                    const std::size_t rows = fill(std::span<T>{ chunk });
+                    const bool end = rows < chunk.size();
+                    {
+                        std::lock_guard lock{ _mutex };
+                        if (rows > 0)
+                            _full.emplace_back(std::move(chunk), rows);
+                        _changed.notify_all();
+                    }
+                    if (end)
+                        break;
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard lock{ _mutex };
+                _error = std::current_exception();
+            }
+
+            std::lock_guard lock{ _mutex };
+            _done = true;
+            _changed.notify_all();
+        }
+
+        std::mutex _mutex;
+        std::condition_variable_any _changed;
+        std::vector<std::vector<T>> _free;
+        std::deque<std::pair<std::vector<T>, std::size_t>> _full;
+        std::vector<T> _current;
+        std::exception_ptr _error;
+        bool _done = false;
+        // the last member: it is joined before the others are destroyed
+        std::jthread _producer;
+    };
+
+
+    /**
+     * It returns a stream_coalescer of the streams: next_chunk() returns the next
+     * rows value_or(default_value, streams[i]...). The streams are read in
+     * lockstep, all of them move to the next row also when a stream before
+     * has a value. The lvalue streams are referenced, the rvalues are moved.
+     *
+     * \param default_value Value of the rows where no stream has a value
+     * \param ...streams Input ranges of value holders
+     */
+    template<typename DT, std::ranges::viewable_range... Streams>
+    requires (std::ranges::input_range<Streams> && ...)
+    [[nodiscard]] auto coalesce_stream(DT&& default_value, Streams&&... streams)
+    {
+        return stream_coalescer<std::remove_cvref_t<DT>, std::views::all_t<Streams>...>{
+            std::forward<DT>(default_value), std::forward<Streams>(streams)... };
+    }
+
+    /**
+     * Asynchronous version of coalesce_stream: the streams are read by a producer
+     * thread. Only the producer uses the streams until the coalescer is destroyed.
+     *
+     * \param options Rows of the chunks and max chunks in the queue
+     * \param default_value Value of the rows where no stream has a value
+     * \param ...streams Input ranges of value holders
+     */
+    template<typename DT, std::ranges::viewable_range... Streams>
+    requires (std::ranges::input_range<Streams> && ...)
+    [[nodiscard]] std::unique_ptr<async_stream_coalescer<std::remove_cvref_t<DT>>> coalesce_stream_async(
+        const stream_options& options, DT&& default_value, Streams&&... streams)
+    {
+        using T = std::remove_cvref_t<DT>;
+        auto coalescer = std::make_shared<stream_coalescer<T, std::views::all_t<Streams>...>>(
+            std::forward<DT>(default_value), std::forward<Streams>(streams)...);
+        return std::make_unique<async_stream_coalescer<T>>(options,
+            [coalescer](std::span<T> out) { return coalescer->fill(out); });
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,148 @@
+/**********************************************************************
+ * \file   value_or_usdt.h
+ * \brief  Static tracepoints (USDT, the probes of SystemTap) of
+ *         value_or. They are compiled only if S4_VALUE_OR_USDT is
+ *         defined, on ELF targets (Linux) with GCC or Clang on x86-64
+ *         or AArch64; otherwise the probes are empty.
+ *         A probe is a nop and a note in the section .note.stapsdt,
+ *         as in <sys/sdt.h>, so there are no external dependencies
+ *         and the cost is one nop when no tracer is attached.
+ *         The probes of the provider s4_value_or are:
+ *         hit(remaining)        a value to test is not null and wins,
+ *         fallback()            all the values are null,
+ *         call_begin(remaining) before the call of an invocable,
+ *         call_end(remaining)   after the call of an invocable.
+ *         remaining is the number of values to test after the winner
+ *         (or after the invocable), so the index of the winner is
+ *         count - 1 - remaining; it is -1 for the invocable default.
+ *         value_or is inlined, so every call site has its own copy
+ *         of the probes: the address of the probe identifies it.
+ *
+ *         bpftrace -e 'usdt:./app:s4_value_or:fallback { @[usym(reg("ip"))] = count(); }'
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_usdt_H
+#define __value_or_usdt_H
+
+#include <type_traits>
+
+#if defined(S4_VALUE_OR_USDT) && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__aarch64__))
+#define S4_VALUE_OR_USDT_ENABLED 1
+#endif
+
+
+#ifdef S4_VALUE_OR_USDT_ENABLED
+
+// constraint of the arguments: on x86-64 they can be also constants
+// or memory operands, that the tracers read without a register
+#if defined(__x86_64__)
+#define S4_VALUE_OR_USDT_ARG "nor"
+#else
+#define S4_VALUE_OR_USDT_ARG "r"
+#endif
+
+// the nop is the probe, the note has its address, the one of the
+// section .stapsdt.base (for the prelinked libraries), no semaphore,
+// the provider, the name and the description of the arguments
+#define S4_VALUE_OR_USDT_ASM(name, args)                                        \
+    "990: nop\n"                                                                \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                               \
+    ".balign 4\n"                                                               \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                          \
+    "991: .asciz \"stapsdt\"\n"                                                 \
+    "992: .balign 4\n"                                                          \
+    "993: .8byte 990b\n"                                                        \
+    ".8byte _.stapsdt.base\n"                                                   \
+    ".8byte 0\n"                                                                \
+    ".asciz \"s4_value_or\"\n"                                                  \
+    ".asciz \"" name "\"\n"                                                     \
+    ".asciz \"" args "\"\n"                                                     \
+    "994: .balign 4\n"                                                          \
+    ".popsection\n"                                                             \
+    ".ifndef _.stapsdt.base\n"                                                  \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"     \
+    ".weak _.stapsdt.base\n"                                                    \
+    ".hidden _.stapsdt.base\n"                                                  \
+    "_.stapsdt.base: .space 1\n"                                                \
+    ".size _.stapsdt.base, 1\n"                                                 \
+    ".popsection\n"                                                             \
+    ".endif\n"
+
+#endif
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    namespace usdt_impl
+    {
+#ifdef S4_VALUE_OR_USDT_ENABLED
+
+        // the probes are always inlined, so each call site has its own probe;
+        // they are skipped during the constant evaluation
+#define S4_VALUE_OR_USDT_PROBE_0(name)                                          \
+        [[gnu::always_inline]] constexpr void name() noexcept                   \
+        {                                                                       \
+            if (!std::is_constant_evaluated())                                  \
+                __asm__ __volatile__(S4_VALUE_OR_USDT_ASM(#name, ""));          \
+        }
+
+#define S4_VALUE_OR_USDT_PROBE_1(name)                                          \
+        [[gnu::always_inline]] constexpr void name(long long remaining) noexcept \
+        {                                                                       \
+            if (!std::is_constant_evaluated())                                  \
+                __asm__ __volatile__(S4_VALUE_OR_USDT_ASM(#name, "-8@%0")       \
+                    : : S4_VALUE_OR_USDT_ARG(remaining));                       \
+        }
+
+#else
+
+#define S4_VALUE_OR_USDT_PROBE_0(name)                                          \
+        constexpr void name() noexcept {}
+
+#define S4_VALUE_OR_USDT_PROBE_1(name)                                          \
+        constexpr void name(long long) noexcept {}
+
+#endif
+
+        S4_VALUE_OR_USDT_PROBE_0(fallback)
+        S4_VALUE_OR_USDT_PROBE_1(hit)
+        S4_VALUE_OR_USDT_PROBE_1(call_begin)
+        S4_VALUE_OR_USDT_PROBE_1(call_end)
+
+#undef S4_VALUE_OR_USDT_PROBE_0
+#undef S4_VALUE_OR_USDT_PROBE_1
+
+        /**
+         * It returns f(), between the probes call_begin and call_end. call_end
+         * is fired by the destructor of a guard, after the result is built.
+         */
+        template<typename F>
+#ifdef S4_VALUE_OR_USDT_ENABLED
+        [[gnu::always_inline]]
+#endif
+        constexpr std::invoke_result_t<F&> call(long long remaining, F& f)
+        {
+#ifdef S4_VALUE_OR_USDT_ENABLED
+            struct call_guard
+            {
+                long long remaining;
+                [[gnu::always_inline]] constexpr ~call_guard() { call_end(remaining); }
+            };
+
+            call_begin(remaining);
+            const call_guard guard{ remaining };
+#else
+            (void)remaining;
+#endif
+            return f();
+        }
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,245 @@
+/**********************************************************************
+ * \file   value_or_within.h
+ * \brief  It contains the function:
+ *         value_or_within(deadline, default_value, to_test_v...).
+ *         It is value_or with a time budget for the invocable values
+ *         to test: each invocable receives a value_or_budget, with
+ *         the remaining time and a std::stop_token, and it is skipped
+ *         when the deadline has passed or the stop is requested.
+ *         The invocables must check the budget themselves to stop a
+ *         long work early; capped(max_duration, f) gives to f a
+ *         budget of at most max_duration.
+ *
+ * \author Roberto
+ * \date   October 2026
+ *********************************************************************/
+
+#ifndef __value_or_within_H
+#define __value_or_within_H
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+
+#include "value_or.h"
+
+
+namespace s4 // Small Simple Stupid Stuff namespace
+{
+
+    /**
+     * Time budget of an invocable value to test: the deadline and the stop
+     * token of value_or_within.
+     */
+    class value_or_budget
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        value_or_budget(clock::time_point deadline, std::stop_token token = {}) noexcept
+            : _deadline{ deadline }, _token{ std::move(token) }
+        {}
+
+        [[nodiscard]] clock::time_point deadline() const noexcept
+        {
+            return _deadline;
+        }
+
+        [[nodiscard]] const std::stop_token& stop_token() const noexcept
+        {
+            return _token;
+        }
+
+        /**
+         * It returns the time until the deadline, zero if it has passed.
+         */
+        [[nodiscard]] clock::duration remaining() const noexcept
+        {
+            return std::max(_deadline - clock::now(), clock::duration::zero());
+        }
+
+        /**
+         * It returns true if the deadline has passed or the stop has been requested.
+         */
+        [[nodiscard]] bool expired() const noexcept
+        {
+            return _token.stop_requested() || clock::now() >= _deadline;
+        }
+
+    private:
+        clock::time_point _deadline;
+        std::stop_token _token;
+    };
+
+
+    namespace within_impl
+    {
+        template<typename F>
+        struct capped_source
+        {
+            value_or_budget::clock::duration max_duration;
+            F f;
+
+            decltype(auto) operator()(const value_or_budget& budget) const
+            {
+                const value_or_budget capped_budget{
+                    std::min(budget.deadline(), value_or_budget::clock::now() + max_duration),
+                    budget.stop_token() };
+                return f(capped_budget);
+            }
+        };
+
+        template<typename T, typename PT>
+        bool take(std::optional<T>& result, PT&& value_holder)
+        {
+            if (!value_holder)
+                return false;
+            result.emplace(*value_holder);
+            return true;
+        }
+
+        /**
+         * Requirements of the values to test: the parameters of value_or and
+         * the invocables with a const value_or_budget& parameter that return
+         * a value holder.
+         */
+        template<typename PT, typename T>
+        concept within_param = value_or_param<PT, T>
+            || requires(PT callable, const value_or_budget& budget)
+        {
+            {callable(budget)} -> value_or_value_holder<T>;
+        };
+
+        /**
+         * It returns true if the invocable to_test is null, like an empty
+         * std::function or a null function pointer.
+         */
+        template<typename PT>
+        bool null_callable(const PT& to_test)
+        {
+            if constexpr (requires { {!to_test} -> std::convertible_to<bool>; })
+                return !to_test;
+            else
+                return false;
+        }
+
+        /**
+         * It tests to_test: if it has a value it writes it in result and returns true.
+         * The invocables are called only if they are not null and the budget is
+         * not expired.
+         */
+        template<typename T, typename PT>
+        bool try_source(std::optional<T>& result, const value_or_budget& budget, PT&& to_test)
+        {
+            if constexpr (std::same_as<std::remove_cvref_t<PT>, std::nullptr_t>)
+            {
+                return false;
+            }
+            else if constexpr (std::invocable<PT&, const value_or_budget&>)
+            {
+                return !null_callable(to_test) && !budget.expired() && take(result, to_test(budget));
+            }
+            else if constexpr (std::invocable<PT&>)
+            {
+                return !null_callable(to_test) && !budget.expired() && take(result, to_test());
+            }
+            else if constexpr (requires { to_test.lock(); })
+            {
+                return take(result, to_test.lock());
+            }
+            else
+            {
+                return take(result, to_test);
+            }
+        }
+
+        template<typename T, typename DT>
+        T make_default(DT&& default_value)
+        {
+            if constexpr (std::invocable<DT&>)
+                return default_value();
+            else
+                return std::forward<DT>(default_value);
+        }
+
+        template<typename DT>
+        struct result
+        {
+            using type = std::remove_cvref_t<DT>;
+        };
+
+        template<typename DT>
+        requires std::invocable<DT&>
+        struct result<DT>
+        {
+            using type = std::remove_cvref_t<std::invoke_result_t<DT&>>;
+        };
+    }
+
+
+    /**
+     * It returns an invocable value for value_or_within that calls f with a
+     * budget of at most max_duration: the deadline of f is the earliest between
+     * now + max_duration and the deadline of value_or_within.
+     *
+     * \param max_duration Max time that f can use
+     * \param f Invocable with a const value_or_budget& parameter
+     */
+    template<typename Rep, typename Period, typename F>
+    requires std::invocable<const std::decay_t<F>&, const value_or_budget&>
+    [[nodiscard]] auto capped(std::chrono::duration<Rep, Period> max_duration, F&& f)
+    {
+        return within_impl::capped_source<std::decay_t<F>>{
+            std::chrono::ceil<value_or_budget::clock::duration>(max_duration), std::forward<F>(f) };
+    }
+
+    /**
+     * Version of value_or with a deadline. The values to test are checked in
+     * order, like in value_or; the invocables are called with a value_or_budget,
+     * or without parameters, only if the deadline has not passed and the stop
+     * has not been requested, otherwise they are skipped. The null invocables
+     * (empty std::function, null function pointers) are skipped like in value_or.
+     * The result is a copy of the value found, because the invocables can
+     * return temporary value holders.
+     *
+     * \param deadline Time after which the invocables are skipped
+     * \param token Stop token: after a stop request the invocables are skipped
+     * \param default_value Value to return if no value is found, or invocable
+     *        that returns it; it is used also when the deadline has passed
+     * \param ...to_test_v Values to check and invocables that return them
+     * \return The first value found, or the default value
+     */
+    template<typename DT, typename... Args>
+    requires (within_impl::within_param<Args, typename within_impl::result<DT>::type> && ...)
+    [[nodiscard]] typename within_impl::result<DT>::type value_or_within(
+        value_or_budget::clock::time_point deadline, std::stop_token token, DT&& default_value, Args&&... to_test_v)
+    {
+        using T = typename within_impl::result<DT>::type;
+
+        const value_or_budget budget{ deadline, std::move(token) };
+        std::optional<T> result;
+        if ((within_impl::try_source(result, budget, std::forward<Args>(to_test_v)) || ...))
+            return std::move(*result);
+        return within_impl::make_default<T>(std::forward<DT>(default_value));
+    }
+
+    /**
+     * Version of value_or_within without a stop token.
+     */
+    template<typename DT, typename... Args>
+    requires (!std::same_as<std::remove_cvref_t<DT>, std::stop_token>)
+        && (within_impl::within_param<Args, typename within_impl::result<DT>::type> && ...)
+    [[nodiscard]] typename within_impl::result<DT>::type value_or_within(
+        value_or_budget::clock::time_point deadline, DT&& default_value, Args&&... to_test_v)
+    {
+        return value_or_within(deadline, std::stop_token{}, std::forward<DT>(default_value), std::forward<Args>(to_test_v)...);
+    }
+
+} // end namespace s4
+
+#endif
@@ -0,0 +1,110 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_adaptive.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <random>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+namespace
+{
+    struct test_column
+    {
+        std::vector<int> values;
+        std::vector<std::uint8_t> valid;
+
+        // the rows of the block b are null with probability null_percent(b)
+        template<typename F>
+        test_column(std::size_t rows, unsigned seed, F null_percent)
+        {
+            std::mt19937 gen{ seed };
+            std::uniform_int_distribution<int> dist{ 0, 99 };
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                valid.push_back(dist(gen) >= null_percent(i / 512));
+                values.push_back(dist(gen));
+            }
+        }
+
+        nullable_column<int> column() const
+        {
+            return { values, valid };
+        }
+
+        std::optional<int> operator[](std::size_t i) const
+        {
+            return valid[i] ? std::optional<int>{ values[i] } : std::nullopt;
+        }
+    };
+}
+
+
+TEST(TestAdaptive, SameAsValueOr)
+{
+    for (std::size_t rows : { 0, 1, 100, 512, 513, 5000 })
+    {
+        const test_column c0{ rows, 1, [](std::size_t b) { return static_cast<int>(b * 37 % 101); } };
+        const test_column c1{ rows, 2, [](std::size_t b) { return b % 3 == 0 ? 100 : 40; } };
+        const test_column c2{ rows, 3, [](std::size_t b) { return b % 2 == 0 ? 100 : 0; } };
+
+        std::vector<int> out(rows);
+        std::vector<adaptive_kernel> choices(value_or_adaptive_blocks(rows));
+        value_or_adaptive(-1, std::span(out), std::span(choices), c0.column(), c1.column(), c2.column());
+
+        for (std::size_t i = 0; i < rows; ++i)
+            EXPECT_EQ(out[i], value_or(-1, c0[i], c1[i], c2[i]));
+    }
+}
+
+TEST(TestAdaptive, Choices)
+{
+    // block 0: all null, 1: first column full, 2: first column almost full,
+    // 3: random, 4: the second column always wins
+    const std::size_t rows = 5 * 512;
+    const test_column c0{ rows, 1, [](std::size_t b) { constexpr int p[] = { 100, 0, 1, 50, 100 }; return p[b]; } };
+    const test_column c1{ rows, 2, [](std::size_t b) { constexpr int p[] = { 100, 50, 50, 50, 0 }; return p[b]; } };
+
+    std::vector<int> out(rows);
+    std::vector<adaptive_kernel> choices(value_or_adaptive_blocks(rows));
+    value_or_adaptive(-1, std::span(out), std::span(choices), c0.column(), c1.column());
+
+    EXPECT_EQ(choices, (std::vector<adaptive_kernel>{ adaptive_kernel::fill_default, adaptive_kernel::copy_first,
+        adaptive_kernel::branchy, adaptive_kernel::blend, adaptive_kernel::branchy }));
+    for (std::size_t i = 0; i < rows; ++i)
+        EXPECT_EQ(out[i], value_or(-1, c0[i], c1[i]));
+
+    EXPECT_EQ(to_string(adaptive_kernel::blend), "blend");
+    EXPECT_EQ(value_or_adaptive_blocks(0), 0u);
+    EXPECT_EQ(value_or_adaptive_blocks(513), 2u);
+}
+
+TEST(TestAdaptive, CorrelatedColumns)
+{
+    // c1 has values exactly where c0 is null: c0 and c1 cover every row, c2 is skipped
+    const std::size_t rows = 1003;
+    test_column c0{ rows, 4, [](std::size_t) { return 50; } };
+    test_column c1{ rows, 5, [](std::size_t) { return 50; } };
+    const test_column c2{ rows, 6, [](std::size_t) { return 50; } };
+    for (std::size_t i = 0; i < rows; ++i)
+        c1.valid[i] = !c0.valid[i];
+
+    std::vector<int> out(rows);
+    std::vector<adaptive_kernel> choices(value_or_adaptive_blocks(rows));
+    value_or_adaptive(-1, std::span(out), std::span(choices), c0.column(), c1.column(), c2.column());
+    EXPECT_EQ(choices, (std::vector<adaptive_kernel>{ adaptive_kernel::blend, adaptive_kernel::blend }));
+    for (std::size_t i = 0; i < rows; ++i)
+        EXPECT_EQ(out[i], value_or(-1, c0[i], c1[i], c2[i]));
+
+    // a row not covered by c0 and c1, between the sampled rows, needs c2
+    c0.valid[5] = 0;
+    c1.valid[5] = 0;
+    value_or_adaptive(-1, std::span(out), c0.column(), c1.column(), c2.column());
+    for (std::size_t i = 0; i < rows; ++i)
+        EXPECT_EQ(out[i], value_or(-1, c0[i], c1[i], c2[i]));
+}
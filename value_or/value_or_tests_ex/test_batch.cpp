@@ -0,0 +1,154 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_batch.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+template<typename T>
+struct test_column
+{
+    std::vector<T> values;
+    std::vector<std::uint8_t> valid;
+
+    test_column(std::size_t rows, unsigned seed, int null_percent)
+    {
+        std::mt19937 gen{ seed };
+        std::uniform_int_distribution<int> dist{ 0, 99 };
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            valid.push_back(dist(gen) >= null_percent);
+            values.push_back(static_cast<T>(dist(gen)));
+        }
+    }
+
+    nullable_column<T> column() const
+    {
+        return { values, valid };
+    }
+
+    std::optional<T> operator[](std::size_t i) const
+    {
+        return valid[i] ? std::optional<T>{ values[i] } : std::nullopt;
+    }
+};
+
+
+TEST(Testvalue_or_batch, SameAsValueOr)
+{
+    for (std::size_t rows : { 0, 1, 100, 512, 513, 2000 })
+    {
+        const test_column<int> c0{ rows, 1, 70 };
+        const test_column<int> c1{ rows, 2, 50 };
+        const test_column<int> c2{ rows, 3, 30 };
+
+        std::vector<int> out(rows);
+        value_or_batch(-1, std::span(out), c0.column(), c1.column(), c2.column());
+
+        for (std::size_t i = 0; i < rows; ++i)
+            EXPECT_EQ(out[i], value_or(-1, c0[i], c1[i], c2[i]));
+    }
+}
+
+TEST(Testvalue_or_batch, Double)
+{
+    const test_column<double> c0{ 1000, 4, 50 };
+    const test_column<double> c1{ 1000, 5, 50 };
+
+    std::vector<double> out(1000);
+    value_or_batch(0.5, std::span(out), c0.column(), c1.column());
+
+    for (std::size_t i = 0; i < out.size(); ++i)
+        EXPECT_EQ(out[i], value_or(0.5, c0[i], c1[i]));
+}
+
+TEST(Testvalue_or_batch, Winners)
+{
+    const std::size_t rows = 1500;
+    const test_column<long long> c0{ rows, 6, 60 };
+    const test_column<long long> c1{ rows, 7, 60 };
+    const test_column<long long> c2{ rows, 8, 60 };
+
+    std::vector<long long> out(rows);
+    std::vector<std::uint8_t> winners(rows);
+    std::vector<std::size_t> hits(4);
+    arg_value_or_batch(7LL, std::span(out), winners, hits, c0.column(), c1.column(), c2.column());
+
+    std::vector<std::size_t> expected_hits(4);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        EXPECT_EQ(out[i], value_or(7LL, c0[i], c1[i], c2[i]));
+
+        const std::uint8_t expected = c0[i] ? 0 : c1[i] ? 1 : c2[i] ? 2 : value_or_default_index;
+        EXPECT_EQ(winners[i], expected);
+        ++expected_hits[expected == value_or_default_index ? 3 : expected];
+    }
+    EXPECT_EQ(hits, expected_hits);
+
+    std::vector<std::size_t> only_hits(4);
+    arg_value_or_batch(7LL, std::span(out), {}, only_hits, c0.column(), c1.column(), c2.column());
+    EXPECT_EQ(only_hits, expected_hits);
+}
+
+TEST(Testvalue_or_batch, WrongSizes)
+{
+    const std::size_t rows = 100;
+    const test_column<int> c0{ rows, 9, 50 };
+    const test_column<int> c1{ rows, 10, 50 };
+
+    std::vector<int> out(rows);
+    std::vector<std::uint8_t> winners(rows - 1);
+    std::vector<std::size_t> hits(3);
+    std::vector<std::size_t> wrong_hits(2);
+    EXPECT_THROW(arg_value_or_batch(0, std::span(out), winners, c0.column(), c1.column()), std::invalid_argument);
+    EXPECT_THROW(arg_value_or_batch(0, std::span(out), winners, hits, c0.column(), c1.column()), std::invalid_argument);
+    EXPECT_THROW(arg_value_or_batch(0, std::span(out), {}, wrong_hits, c0.column(), c1.column()), std::invalid_argument);
+    EXPECT_THROW(arg_value_or_batch(0, std::span(out), {}, {}, c0.column(), c1.column()), std::invalid_argument);
+
+    winners.resize(rows);
+    EXPECT_NO_THROW(arg_value_or_batch(0, std::span(out), winners, hits, c0.column(), c1.column()));
+    EXPECT_EQ(hits[0] + hits[1] + hits[2], rows);
+}
+
+TEST(Testvalue_or_batch, Reduce)
+{
+    for (std::size_t rows : { 1, 3, 4, 100, 512, 513, 3001 })
+    {
+        const test_column<int> c0{ rows, 9, 60 };
+        const test_column<int> c1{ rows, 10, 40 };
+
+        int sum = 0;
+        int min = std::numeric_limits<int>::max();
+        int max = std::numeric_limits<int>::lowest();
+        std::size_t defaulted = 0;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            const int v = value_or(-3, c0[i], c1[i]);
+            sum += v;
+            min = std::min(min, v);
+            max = std::max(max, v);
+            defaulted += !c0[i] && !c1[i];
+        }
+
+        EXPECT_EQ(value_or_sum(-3, c0.column(), c1.column()), sum);
+        EXPECT_EQ(value_or_min(-3, c0.column(), c1.column()), min);
+        EXPECT_EQ(value_or_max(-3, c0.column(), c1.column()), max);
+        EXPECT_EQ(value_or_count_default(c0.column(), c1.column()), defaulted);
+        EXPECT_DOUBLE_EQ(*value_or_mean(-3, c0.column(), c1.column()), static_cast<double>(sum) / static_cast<double>(rows));
+        EXPECT_EQ(value_or_reduce(-3, 0, [](int a, int b) { return a ^ b; }, c0.column(), c1.column()),
+            [&]() { int x = 0; for (std::size_t i = 0; i < rows; ++i) x ^= value_or(-3, c0[i], c1[i]); return x; }());
+    }
+
+    const nullable_column<int> empty{};
+    EXPECT_EQ(value_or_min(0, empty), std::nullopt);
+    EXPECT_EQ(value_or_mean(0, empty), std::nullopt);
+    EXPECT_EQ(value_or_sum(0, empty), 0);
+}
@@ -0,0 +1,57 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_branchless.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <random>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testvalue_or_branchless, Pointers)
+{
+    const int a = 1;
+    int b = 2;
+    const int* null = nullptr;
+
+    EXPECT_EQ(value_or_branchless(0), 0);
+    EXPECT_EQ(value_or_branchless(0, null), 0);
+    EXPECT_EQ(value_or_branchless(0, &a, &b), 1);
+    EXPECT_EQ(value_or_branchless(0, null, &b), 2);
+    EXPECT_EQ(value_or_branchless(0, null, &b, &a), 2);
+    EXPECT_EQ(value_or_branchless(0, null, null, &a), 1);
+}
+
+TEST(Testvalue_or_branchless, Optionals)
+{
+    const std::optional<double> empty;
+    const std::optional<double> half{ 0.5 };
+    const double two = 2.0;
+
+    EXPECT_EQ(value_or_branchless(1.0, empty), 1.0);
+    EXPECT_EQ(value_or_branchless(1.0, half), 0.5);
+    EXPECT_EQ(value_or_branchless(1.0, empty, &two, half), 2.0);
+    EXPECT_EQ(value_or_branchless(1.0, empty, static_cast<const double*>(nullptr), half), 0.5);
+}
+
+TEST(Testvalue_or_branchless, SameAsValueOr)
+{
+    std::mt19937 gen{ 11 };
+    std::bernoulli_distribution null{ 0.5 };
+    std::uniform_int_distribution<long long> value{ -1000, 1000 };
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        const std::optional<long long> o0 = null(gen) ? std::nullopt : std::optional<long long>{ value(gen) };
+        const std::optional<long long> o1 = null(gen) ? std::nullopt : std::optional<long long>{ value(gen) };
+        const long long v2 = value(gen);
+        const long long* p2 = null(gen) ? nullptr : &v2;
+
+        EXPECT_EQ(value_or_branchless(7LL, o0, o1, p2), value_or(7LL, o0, o1, p2));
+        EXPECT_EQ(value_or_branchless(7LL, p2, o1), value_or(7LL, p2, o1));
+    }
+}
@@ -0,0 +1,78 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_cell.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <string>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testversioned, Holder)
+{
+    versioned<int> v;
+    EXPECT_EQ(v.version(), 0u);
+    EXPECT_EQ(value_or(1, v), 1);
+
+    v.set(2);
+    EXPECT_EQ(v.version(), 1u);
+    EXPECT_EQ(value_or(1, v), 2);
+
+    v.reset();
+    EXPECT_EQ(v.version(), 2u);
+    EXPECT_EQ(value_or(1, v), 1);
+}
+
+TEST(Testcoalesced_cell, Recompute)
+{
+    versioned<std::string> a;
+    versioned<std::string> b{ "b" };
+    versioned<std::string> c{ "c" };
+    coalesced_cell cell{ std::string{ "def" }, a, b, c };
+
+    EXPECT_EQ(cell.get(), "b");
+    EXPECT_EQ(cell.winner(), 1u);
+
+    c.set("c2"); // below the winner, it cannot change the result
+    EXPECT_EQ(cell.get(), "b");
+    EXPECT_EQ(cell.winner(), 1u);
+
+    a.set("a");
+    EXPECT_EQ(cell.get(), "a");
+    EXPECT_EQ(cell.winner(), 0u);
+
+    a.reset();
+    b.reset();
+    EXPECT_EQ(cell.get(), "c2");
+    EXPECT_EQ(cell.winner(), 2u);
+
+    c.reset();
+    EXPECT_EQ(cell.get(), "def");
+    EXPECT_EQ(cell.winner(), 3u);
+
+    b.set("b2");
+    EXPECT_EQ(cell.get(), value_or(std::string{ "def" }, a, b, c));
+    EXPECT_EQ(cell.winner(), 1u);
+}
+
+TEST(Testcoalesced_cell, OtherChanges)
+{
+    versioned<int> a;
+    versioned<int> b{ 2 };
+    versioned<int> other{ 0 };
+    coalesced_cell cell{ 9, a, b };
+    EXPECT_EQ(cell.get(), 2);
+
+    // a change of a versioned that is not a source checks the sources,
+    // but the value stays
+    other.set(1);
+    EXPECT_EQ(cell.get(), 2);
+    EXPECT_EQ(cell.get(), 2);
+
+    a.set(1);
+    other.set(2);
+    EXPECT_EQ(cell.get(), 1);
+    EXPECT_EQ(cell.winner(), 0u);
+}
@@ -0,0 +1,123 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_chain.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <stdexcept>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testcoalesce_chain, Sources)
+{
+    int a = 1;
+    const int b = 2;
+    std::optional<int> o;
+    const int* null = nullptr;
+
+    coalesce_chain<int, 8> chain;
+    EXPECT_EQ(chain.value_or(0), 0);
+
+    chain.push_back(null);
+    chain.push_back([&o]() { return o; });
+    chain.push_back(&a);
+    chain.push_back(&b);
+    EXPECT_EQ(chain.size(), 4);
+    EXPECT_EQ(chain.value_or(0), 1);
+    EXPECT_EQ(chain.value_or(0), value_or(0, null, o, &a, &b));
+
+    o = 5;
+    EXPECT_EQ(chain.value_or(0), 5);
+
+    a = 3;
+    o.reset();
+    EXPECT_EQ(chain.value_or(0), 3);
+
+    chain.freeze();
+    EXPECT_TRUE(chain.frozen());
+    EXPECT_EQ(chain.value_or(0), 3);
+    o = 6;
+    EXPECT_EQ(chain.value_or(0), 6);
+}
+
+TEST(Testcoalesce_chain, Freeze)
+{
+    const int a = 1;
+    const int* pa = &a;
+    const int* null = nullptr;
+
+    coalesce_chain<int, 5> chain;
+    chain.push_back(null);
+    chain.push_back(7);
+    chain.push_back(pa);
+    EXPECT_EQ(chain.value_or(0), 7);
+
+    // the sources after the constant are dropped, the others are pointers
+    chain.freeze();
+    EXPECT_EQ(chain.size(), 2);
+    EXPECT_EQ(chain.value_or(0), 7);
+
+    coalesce_chain<int, 5> pointers;
+    pointers.push_back(null);
+    pointers.push_back(null);
+    pointers.freeze();
+    EXPECT_EQ(pointers.value_or(4), 4);
+    pointers.push_back(pa);
+    EXPECT_FALSE(pointers.frozen());
+    EXPECT_EQ(pointers.value_or(4), 1);
+    pointers.freeze();
+    EXPECT_EQ(pointers.value_or(4), 1);
+
+    // a copy of a frozen chain is still valid
+    const coalesce_chain<int, 5> copy = chain;
+    EXPECT_EQ(copy.value_or(0), 7);
+}
+
+TEST(Testcoalesce_chain, FreezeAllKinds)
+{
+    int a = 1;
+    int* null = nullptr;
+    std::optional<int> o;
+
+    coalesce_chain<int, 6> chain;
+    chain.push_back(null);
+    chain.push_back(std::optional<int>{});
+    chain.push_back([&o]() { return o; });
+    chain.push_back(std::optional<int>{ 4 });
+    chain.push_back(&a);
+    chain.push_back(9);
+    chain.freeze();
+    EXPECT_EQ(chain.size(), 6);
+
+    // the invocable is still called after freeze
+    EXPECT_EQ(chain.value_or(0), 4);
+    o = 2;
+    EXPECT_EQ(chain.value_or(0), 2);
+
+    coalesce_chain<int, 3> no_value;
+    no_value.push_back(std::optional<int>{});
+    no_value.push_back(null);
+    no_value.freeze();
+    EXPECT_EQ(no_value.value_or(5), 5);
+
+    // the optionals are read from the entries of the copy
+    coalesce_chain<int, 3> optionals;
+    optionals.push_back(std::optional<int>{});
+    optionals.push_back(std::optional<int>{ 3 });
+    optionals.freeze();
+    const coalesce_chain<int, 3> copy = optionals;
+    optionals = coalesce_chain<int, 3>{};
+    EXPECT_EQ(copy.value_or(0), 3);
+}
+
+TEST(Testcoalesce_chain, Full)
+{
+    coalesce_chain<double, 2> chain;
+    chain.push_back(std::optional<double>{});
+    chain.push_back(std::optional<double>{ 0.5 });
+    EXPECT_THROW(chain.push_back(1.0), std::length_error);
+    EXPECT_EQ(chain.value_or(2.0), 0.5);
+}
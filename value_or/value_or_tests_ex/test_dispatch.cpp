@@ -0,0 +1,138 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_dispatch.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+namespace
+{
+    template<typename T>
+    struct test_column
+    {
+        std::vector<T> values;
+        std::vector<std::uint8_t> valid;
+
+        test_column(std::size_t rows, unsigned seed, int null_percent)
+        {
+            std::mt19937 gen{ seed };
+            std::uniform_int_distribution<int> dist{ 0, 99 };
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                valid.push_back(dist(gen) >= null_percent);
+                values.push_back(static_cast<T>(dist(gen)));
+            }
+        }
+
+        nullable_column<T> column() const
+        {
+            return { values, valid };
+        }
+    };
+}
+
+
+TEST(TestDispatch, Isa)
+{
+    EXPECT_LE(value_or_active_isa(), value_or_detected_isa());
+    EXPECT_EQ(to_string(value_or_isa::sse4_2), "sse4.2");
+
+    static_assert(dispatch_impl::isa_from_environment(nullptr, value_or_isa::avx2) == value_or_isa::avx2);
+    static_assert(dispatch_impl::isa_from_environment("scalar", value_or_isa::avx2) == value_or_isa::scalar);
+    static_assert(dispatch_impl::isa_from_environment("sse4.2", value_or_isa::avx2) == value_or_isa::sse4_2);
+    static_assert(dispatch_impl::isa_from_environment("avx512", value_or_isa::avx2) == value_or_isa::avx2);
+    static_assert(dispatch_impl::isa_from_environment("neon", value_or_isa::avx2) == value_or_isa::avx2);
+}
+
+TEST(TestDispatch, SameAsNotDispatched)
+{
+    for (std::size_t rows : { 0, 1, 100, 513, 3000 })
+    {
+        const test_column<int> c0{ rows, 1, 60 };
+        const test_column<int> c1{ rows, 2, 40 };
+        const test_column<int> c2{ rows, 3, 20 };
+
+        std::vector<int> expected(rows);
+        std::vector<int> out(rows);
+        value_or_batch(-1, std::span(expected), c0.column(), c1.column(), c2.column());
+        value_or_batch_dispatched(-1, std::span(out), c0.column(), c1.column(), c2.column());
+        EXPECT_EQ(out, expected);
+
+        std::vector<std::uint8_t> expected_winners(rows);
+        std::vector<std::uint8_t> winners(rows);
+        std::vector<std::size_t> expected_hits(4);
+        std::vector<std::size_t> hits(4);
+        arg_value_or_batch(-1, std::span(expected), std::span(expected_winners), std::span(expected_hits),
+            c0.column(), c1.column(), c2.column());
+        arg_value_or_batch_dispatched(-1, std::span(out), std::span(winners), std::span(hits),
+            c0.column(), c1.column(), c2.column());
+        EXPECT_EQ(out, expected);
+        EXPECT_EQ(winners, expected_winners);
+        EXPECT_EQ(hits, expected_hits);
+        if (rows > 1)
+        {
+            EXPECT_THROW(arg_value_or_batch_dispatched(-1, std::span(out), std::span(winners).first(rows / 2), std::span(hits),
+                c0.column(), c1.column(), c2.column()), std::invalid_argument);
+        }
+        EXPECT_THROW(arg_value_or_batch_dispatched(-1, std::span(out), std::span(winners), std::span(hits).first(3),
+            c0.column(), c1.column(), c2.column()), std::invalid_argument);
+
+        value_or_batch_projected(-1, std::span(expected), c0.column(), project_column(c1.column(), affine<int>{ 1000, 1 }));
+        value_or_batch_projected_dispatched(-1, std::span(out), c0.column(), project_column(c1.column(), affine<int>{ 1000, 1 }));
+        EXPECT_EQ(out, expected);
+
+        std::vector<adaptive_kernel> expected_choices(value_or_adaptive_blocks(rows));
+        std::vector<adaptive_kernel> choices(value_or_adaptive_blocks(rows));
+        value_or_adaptive(-1, std::span(expected), std::span(expected_choices), c0.column(), c1.column());
+        value_or_adaptive_dispatched(-1, std::span(out), std::span(choices), c0.column(), c1.column());
+        EXPECT_EQ(out, expected);
+        EXPECT_EQ(choices, expected_choices);
+
+        EXPECT_EQ(value_or_sum_dispatched(-1, c0.column(), c1.column(), c2.column()),
+            value_or_sum(-1, c0.column(), c1.column(), c2.column()));
+        EXPECT_EQ(value_or_min_dispatched(-1, c0.column(), c1.column()), value_or_min(-1, c0.column(), c1.column()));
+        EXPECT_EQ(value_or_max_dispatched(-1, c0.column(), c1.column()), value_or_max(-1, c0.column(), c1.column()));
+        EXPECT_EQ(value_or_mean_dispatched(-1, c0.column(), c1.column()), value_or_mean(-1, c0.column(), c1.column()));
+        EXPECT_EQ(value_or_count_default_dispatched(c0.column(), c1.column(), c2.column()),
+            value_or_count_default(c0.column(), c1.column(), c2.column()));
+
+        const std::string_view names[] = { "A", "B", "C" };
+        const nullable_column<int> columns[] = { c0.column(), c1.column(), c2.column() };
+        const auto rule = coalesce_rule<int>::compile("coalesce(A, B * 1000 + 1, C if A)", names);
+        rule.run(-1, expected, columns);
+        run_dispatched(rule, -1, std::span(out), columns);
+        EXPECT_EQ(out, expected);
+        EXPECT_THROW(run_dispatched(rule, -1, std::span(out), std::span(columns).first(2)), std::invalid_argument);
+    }
+}
+
+TEST(TestDispatch, AllVersions)
+{
+    // every version runs if the processor supports it
+    const test_column<double> c0{ 1000, 4, 50 };
+    const test_column<double> c1{ 1000, 5, 50 };
+    std::vector<double> expected(1000);
+    value_or_batch(0.5, std::span(expected), c0.column(), c1.column());
+
+    using kernel = dispatch_impl::batch_kernel<double, 2>;
+    using versions = dispatch_impl::versions<kernel, void, const double&, dispatch_impl::batch_columns<double, 2>,
+        std::span<double>, std::span<std::uint8_t>, std::span<std::size_t>>;
+    const nullable_column<double> a = c0.column();
+    const nullable_column<double> b = c1.column();
+    for (value_or_isa isa : { value_or_isa::scalar, value_or_isa::sse4_2, value_or_isa::avx2, value_or_isa::avx512 })
+    {
+        if (isa > value_or_detected_isa())
+            continue;
+        std::vector<double> out(1000);
+        versions::select(isa)(0.5, { &a, &b }, out, {}, {});
+        EXPECT_EQ(out, expected) << to_string(isa);
+    }
+}
@@ -0,0 +1,114 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_encoded.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+template<typename T>
+std::vector<std::optional<T>> expand(const std::vector<rle_run<T>>& runs)
+{
+    std::vector<std::optional<T>> r;
+    for (const rle_run<T>& run : runs)
+        r.insert(r.end(), run.length, run.value);
+    return r;
+}
+
+template<typename T>
+std::vector<std::optional<T>> expand(std::size_t rows, const std::vector<std::size_t>& indexes, const std::vector<T>& values)
+{
+    std::vector<std::optional<T>> r(rows);
+    for (std::size_t i = 0; i < indexes.size(); ++i)
+        r[indexes[i]] = values[i];
+    return r;
+}
+
+std::vector<rle_run<int>> random_runs(std::size_t rows, unsigned seed)
+{
+    std::mt19937 gen{ seed };
+    std::uniform_int_distribution<std::size_t> length{ 1, 40 };
+    std::uniform_int_distribution<int> value{ 0, 3 };
+    std::vector<rle_run<int>> r;
+    for (std::size_t row = 0; row < rows; )
+    {
+        const std::size_t n = std::min(length(gen), rows - row);
+        const int v = value(gen);
+        r.push_back({ n, v == 0 ? std::nullopt : std::optional<int>{ v } });
+        row += n;
+    }
+    return r;
+}
+
+
+TEST(Testvalue_or_encoded, Rle)
+{
+    const std::vector<rle_run<int>> a{ { 3, 1 }, { 4, std::nullopt }, { 3, 2 } };
+    const std::vector<rle_run<int>> b{ { 5, std::nullopt }, { 5, 7 } };
+
+    const std::vector<rle_run<int>> expected{ { 3, 1 }, { 2, 0 }, { 2, 7 }, { 3, 2 } };
+    EXPECT_EQ(value_or_rle(0, rle_column<int>{ a }, rle_column<int>{ b }), expected);
+
+    std::vector<int> dense(10);
+    value_or_dense(0, std::span(dense), rle_column<int>{ a }, rle_column<int>{ b });
+    EXPECT_EQ(dense, std::vector<int>({ 1, 1, 1, 0, 0, 7, 7, 2, 2, 2 }));
+}
+
+TEST(Testvalue_or_encoded, Sparse)
+{
+    const std::vector<std::size_t> indexes{ 2, 3, 8 };
+    const std::vector<int> values{ 5, 5, 6 };
+    const sparse_column<int> s{ 10, indexes, values };
+
+    const std::vector<rle_run<int>> expected{ { 2, 0 }, { 2, 5 }, { 4, 0 }, { 1, 6 }, { 1, 0 } };
+    EXPECT_EQ(value_or_rle(0, s), expected);
+
+    const std::vector<rle_run<int>> runs{ { 10, 9 } };
+    const std::vector<rle_run<int>> expected_2{ { 2, 9 }, { 2, 5 }, { 4, 9 }, { 1, 6 }, { 1, 9 } };
+    EXPECT_EQ(value_or_rle(0, s, rle_column<int>{ runs }), expected_2);
+
+    EXPECT_THROW((void)value_or_rle(0, sparse_column<int>{ 11, indexes, values }, rle_column<int>{ runs }), std::invalid_argument);
+}
+
+TEST(Testvalue_or_encoded, SameAsValueOr)
+{
+    const std::size_t rows = 3000;
+    const auto r0 = random_runs(rows, 1);
+    const auto r1 = random_runs(rows, 2);
+
+    std::mt19937 gen{ 3 };
+    std::bernoulli_distribution has_value{ 0.05 };
+    std::vector<std::size_t> indexes;
+    std::vector<int> values;
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        if (has_value(gen))
+        {
+            indexes.push_back(i);
+            values.push_back(static_cast<int>(i));
+        }
+    }
+    const sparse_column<int> s{ rows, indexes, values };
+
+    const auto e0 = expand(r0);
+    const auto e1 = expand(r1);
+    const auto es = expand(rows, indexes, values);
+
+    const auto coalesced = expand(value_or_rle(-1, s, rle_column<int>{ r0 }, rle_column<int>{ r1 }));
+    std::vector<int> dense(rows);
+    value_or_dense(-1, std::span(dense), rle_column<int>{ r0 }, s, rle_column<int>{ r1 });
+
+    ASSERT_EQ(coalesced.size(), rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        EXPECT_EQ(*coalesced[i], value_or(-1, es[i], e0[i], e1[i]));
+        EXPECT_EQ(dense[i], value_or(-1, e0[i], es[i], e1[i]));
+    }
+}
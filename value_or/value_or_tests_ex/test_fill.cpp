@@ -0,0 +1,137 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_fill.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+// scalar forward fill: every row is value_or(row, last resolved row)
+std::vector<std::optional<int>> scalar_ffill(std::vector<std::optional<int>> v, std::size_t max_gap)
+{
+    std::optional<int> last;
+    std::size_t last_row = 0;
+    for (std::size_t i = 0; i < v.size(); ++i)
+    {
+        if (v[i])
+        {
+            last = v[i];
+            last_row = i;
+        }
+        else if (last && i - last_row <= max_gap)
+        {
+            v[i] = value_or(*last, v[i]);
+        }
+    }
+    return v;
+}
+
+std::vector<std::optional<int>> random_column(std::size_t rows, unsigned seed, int null_percent)
+{
+    std::mt19937 gen{ seed };
+    std::uniform_int_distribution<int> dist{ 0, 99 };
+    std::vector<std::optional<int>> v(rows);
+    for (auto& o : v)
+    {
+        if (dist(gen) >= null_percent)
+            o = dist(gen);
+    }
+    return v;
+}
+
+
+TEST(Testfill, Small)
+{
+    std::vector<std::optional<int>> v{ {}, 1, {}, {}, 4, {} };
+    ffill(std::span(v));
+    EXPECT_EQ(v, (std::vector<std::optional<int>>{ {}, 1, 1, 1, 4, 4 }));
+
+    std::vector<std::optional<int>> b{ {}, 1, {}, {}, 4, {} };
+    bfill(std::span(b));
+    EXPECT_EQ(b, (std::vector<std::optional<int>>{ 1, 1, 4, 4, 4, {} }));
+
+    std::vector<std::optional<int>> g{ 1, {}, {}, {}, 5 };
+    ffill(std::span(g), 2);
+    EXPECT_EQ(g, (std::vector<std::optional<int>>{ 1, 1, 1, {}, 5 }));
+}
+
+TEST(Testfill, OptionalSameAsScalar)
+{
+    for (std::size_t rows : { 1, 255, 256, 257, 1000, 5000 })
+    {
+        for (int null_percent : { 10, 90, 100 })
+        {
+            for (std::size_t max_gap : { std::size_t{ 0 }, std::size_t{ 3 }, std::size_t{ 300 }, fill_no_limit })
+            {
+                const auto v = random_column(rows, static_cast<unsigned>(rows), null_percent);
+                const auto expected = scalar_ffill(v, max_gap);
+                for (std::size_t threads : { 1, 3, 8 })
+                {
+                    auto f = v;
+                    ffill(std::span(f), max_gap, threads);
+                    EXPECT_EQ(f, expected);
+
+                    // bfill is the ffill of the reversed column
+                    auto b = v;
+                    bfill(std::span(b), max_gap, threads);
+                    const auto rexpected = scalar_ffill({ v.rbegin(), v.rend() }, max_gap);
+                    EXPECT_EQ(std::vector<std::optional<int>>(b.rbegin(), b.rend()), rexpected);
+                }
+            }
+        }
+    }
+}
+
+TEST(Testfill, Bitmap)
+{
+    const std::size_t rows = 3000;
+    const auto v = random_column(rows, 5, 80);
+    const auto expected = scalar_ffill(v, 10);
+
+    for (std::size_t threads : { 1, 4 })
+    {
+        std::vector<int> values(rows);
+        std::vector<std::uint64_t> bits((rows + 63) / 64);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            values[i] = value_or(-1, v[i]);
+            if (v[i])
+                bits[i / 64] |= std::uint64_t{ 1 } << (i % 64);
+        }
+
+        ffill(std::span(values), std::span(bits), 10, threads);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            const bool valid = (bits[i / 64] >> (i % 64)) & 1;
+            EXPECT_EQ(valid, expected[i].has_value());
+            if (valid)
+            {
+                EXPECT_EQ(values[i], *expected[i]);
+            }
+        }
+    }
+}
+
+TEST(Testfill, NaN)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> v{ nan, 1.5, nan, 2.5, nan };
+    ffill(std::span(v));
+    EXPECT_TRUE(std::isnan(v[0]));
+    EXPECT_EQ(v[2], 1.5);
+    EXPECT_EQ(v[4], 2.5);
+
+    std::vector<double> b{ nan, 1.5, nan, 2.5, nan };
+    bfill(std::span(b));
+    EXPECT_EQ(b[0], 1.5);
+    EXPECT_EQ(b[2], 2.5);
+    EXPECT_TRUE(std::isnan(b[4]));
+}
@@ -0,0 +1,90 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_grouped.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testgroup_value_or, Sorted)
+{
+    const std::vector<std::string> keys{ "a", "a", "a", "b", "b", "c" };
+    const std::vector<std::optional<int>> v1{ {}, {}, 3, {}, {}, {} };
+    const std::vector<std::optional<int>> v2{ {}, 2, 30, {}, {}, 6 };
+
+    const auto r = group_value_or_sorted(keys, v1, v2);
+    ASSERT_EQ(r.size(), 3u);
+    EXPECT_EQ(r[0].first, "a");
+    EXPECT_EQ(r[0].second, 2);
+    EXPECT_EQ(r[1].first, "b");
+    EXPECT_EQ(r[1].second, std::nullopt);
+    EXPECT_EQ(r[2].first, "c");
+    EXPECT_EQ(r[2].second, 6);
+}
+
+TEST(Testgroup_value_or, Hashed)
+{
+    const std::vector<int> keys{ 7, 3, 7, 3, 9 };
+    int i2 = 2;
+    int i4 = 4;
+    const std::vector<const int*> v1{ nullptr, nullptr, &i2, &i4, nullptr };
+
+    const auto r = group_value_or(keys, v1);
+    ASSERT_EQ(r.size(), 3u);
+    EXPECT_EQ(r[0], std::make_pair(7, std::optional<int>{ 2 }));
+    EXPECT_EQ(r[1], std::make_pair(3, std::optional<int>{ 4 }));
+    EXPECT_EQ(r[2], std::make_pair(9, std::optional<int>{}));
+}
+
+TEST(Testgroup_value_or, SameAsMap)
+{
+    const std::size_t rows = 20000;
+    std::mt19937 gen{ 11 };
+    std::uniform_int_distribution<int> key_dist{ 0, 999 };
+    std::uniform_int_distribution<int> dist{ 0, 99 };
+
+    std::vector<long long> keys;
+    std::vector<std::optional<int>> v1;
+    std::vector<std::optional<int>> v2;
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        keys.push_back(key_dist(gen) * 1000003LL);
+        v1.push_back(dist(gen) < 95 ? std::nullopt : std::optional<int>{ dist(gen) });
+        v2.push_back(dist(gen) < 90 ? std::nullopt : std::optional<int>{ dist(gen) + 100 });
+    }
+
+    // the scalar version: std::map and value_or for every row
+    std::map<long long, std::optional<int>> expected;
+    std::vector<long long> order;
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        auto [it, inserted] = expected.try_emplace(keys[i]);
+        if (inserted)
+            order.push_back(keys[i]);
+        if (!it->second && (v1[i] || v2[i]))
+            it->second = value_or(0, v1[i], v2[i]);
+    }
+
+    const auto check = [&](const auto& r)
+    {
+        ASSERT_EQ(r.size(), order.size());
+        for (std::size_t g = 0; g < r.size(); ++g)
+        {
+            EXPECT_EQ(r[g].first, order[g]);
+            EXPECT_EQ(r[g].second, expected[order[g]]);
+        }
+    };
+
+    check(group_value_or(keys, v1, v2));
+    check(group_value_or_parallel(1, keys, v1, v2));
+    check(group_value_or_parallel(4, keys, v1, v2));
+    check(group_value_or_parallel(7, keys, v1, v2));
+}
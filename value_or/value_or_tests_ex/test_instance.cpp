@@ -0,0 +1,68 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_common_instances.h"
+#include "../value_or_ex/value_or_instance.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <memory>
+#include <optional>
+#include <string>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+// the instances that are not in S4_VALUE_OR_COMMON_INSTANCES
+#define TEST_INSTANCES(X)                                       \
+    X(int, const int*, std::optional<int>)                      \
+    X(std::string, std::shared_ptr<std::string>, std::optional<std::string>)
+
+TEST_INSTANCES(S4_VALUE_OR_EXTERN)
+
+static_assert(std::is_same_v<instance_impl::canonical_t<int* const&>, const int*>);
+static_assert(std::is_same_v<instance_impl::canonical_t<const int*>, const int*>);
+static_assert(std::is_same_v<instance_impl::canonical_t<const std::optional<int>&>, std::optional<int>>);
+
+
+TEST(Testvalue_or_instance, SameAsValueOr)
+{
+    const int i = 1;
+    const int* pi = &i;
+    const int* const null = nullptr;
+    std::optional<int> o{ 2 };
+    const std::optional<int>& co = o;
+
+    // all the const and reference variants call the same instance
+    EXPECT_EQ(value_or_canonical(0, pi, o), 1);
+    EXPECT_EQ(value_or_canonical(0, null, co), 2);
+    EXPECT_EQ(value_or_canonical(0, null, std::optional<int>{}), 0);
+    EXPECT_EQ(value_or_canonical(0, null, co), value_or(0, null, co));
+
+    auto s = std::make_shared<std::string>("shared");
+    std::string text = "text";
+    const std::string default_value = "default";
+    EXPECT_EQ(value_or_canonical(default_value, s, &text), "shared");
+    s.reset();
+    EXPECT_EQ(value_or_canonical(default_value, s, &text), "text");
+    EXPECT_EQ(value_or_canonical(default_value, s, static_cast<std::string*>(nullptr)), "default");
+    EXPECT_EQ(value_or_canonical(default_value, s, std::optional<std::string>{ "optional" }), "optional");
+}
+
+TEST(Testvalue_or_instance, CommonInstances)
+{
+    int i = 3;
+    int* pi = &i;
+    const std::optional<int> o{ 4 };
+    const std::string text = "text";
+
+    // int* uses the instance of const int*
+    EXPECT_EQ(value_or_canonical(0, pi), 3);
+    EXPECT_EQ(value_or_canonical(0, static_cast<int*>(nullptr), pi), 3);
+    EXPECT_EQ(value_or_canonical(0, std::optional<int>{}, o), 4);
+    EXPECT_EQ(value_or_canonical(std::string{ "default" }, &text), "text");
+}
+
+// the instantiation translation units, usually separate files
+TEST_INSTANCES(S4_VALUE_OR_INSTANTIATE)
+S4_VALUE_OR_COMMON_INSTANCES(S4_VALUE_OR_INSTANTIATE)
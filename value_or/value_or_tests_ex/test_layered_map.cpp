@@ -0,0 +1,208 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_layered_map.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testlayered_map, Priority)
+{
+    layered_map<std::string, int> m{ 3 };
+    EXPECT_EQ(m.get("a"), std::nullopt);
+    EXPECT_EQ(value_or(1, m.get("a")), 1);
+
+    m.set(2, "a", 20);
+    EXPECT_EQ(m.get("a"), 20);
+    EXPECT_EQ(m.layer_of("a"), 2u);
+
+    m.set(0, "a", 0);
+    EXPECT_EQ(m.get("a"), 0);
+    EXPECT_EQ(m.layer_of("a"), 0u);
+
+    m.set(1, "a", 10);  // hidden by the layer 0
+    EXPECT_EQ(m.get("a"), 0);
+
+    m.erase(0, "a");
+    EXPECT_EQ(m.get("a"), 10);
+    m.erase(1, "a");
+    EXPECT_EQ(m.get("a"), 20);
+    m.erase(2, "a");
+    EXPECT_EQ(m.get("a"), std::nullopt);
+    EXPECT_EQ(m.layer_of("a"), value_or_npos);
+
+    m.erase(2, "b");
+    EXPECT_EQ(m.get("b"), std::nullopt);
+}
+
+TEST(Testlayered_map, Update)
+{
+    layered_map<int, std::string> m{ 2 };
+    const std::vector<std::pair<int, std::optional<std::string>>> global{ {1, "g1"}, {2, "g2"}, {3, "g3"} };
+    m.update(1, global);
+
+    const std::vector<std::pair<int, std::optional<std::string>>> session{ {2, "s2"}, {3, std::nullopt} };
+    m.update(0, session);
+
+    EXPECT_EQ(m.get(1), "g1");
+    EXPECT_EQ(m.get(2), "s2");
+    EXPECT_EQ(m.get(3), "g3");
+}
+
+TEST(Testlayered_map, ConcurrentReaders)
+{
+    layered_map<int, long long> m{ 4 };
+    for (int k = 0; k < 64; ++k)
+        m.set(3, k, -1);
+
+    std::atomic<bool> stop{ false };
+    std::atomic<bool> error{ false };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&m, &stop, &error]()
+        {
+            while (!stop.load())
+            {
+                for (int k = 0; k < 64; ++k)
+                {
+                    // the writer sets only values whose layer is their last digit
+                    const long long v = value_or(0LL, m.get(k));
+                    if (v != -1 && v % 10 > 2)
+                        error.store(true);
+                }
+            }
+        });
+    }
+
+    for (long long i = 0; i < 2000; ++i)
+    {
+        const std::size_t layer = static_cast<std::size_t>(i % 3);
+        m.set(layer, static_cast<int>(i % 64), i * 10 + static_cast<long long>(layer));
+        if (i % 7 == 0)
+            m.erase(layer, static_cast<int>(i % 64));
+    }
+
+    stop.store(true);
+    for (auto& t : readers)
+        t.join();
+    EXPECT_FALSE(error.load());
+}
+
+TEST(Testlayered_map, Growth)
+{
+    // enough keys to double the buckets several times, the tree gets more levels
+    layered_map<int, int> m{ 2 };
+    std::map<int, std::pair<int, std::size_t>> expected;
+    for (int i = 0; i < 20000; ++i)
+    {
+        m.set(1, i, i);
+        expected[i] = { i, 1 };
+    }
+    for (int i = 0; i < 20000; i += 3)
+    {
+        m.set(0, i, -i);
+        expected[i] = { -i, 0 };
+    }
+    for (int i = 0; i < 20000; i += 5)
+    {
+        m.erase(1, i);
+        if (expected[i].second == 1)
+            expected.erase(i);
+    }
+    for (int i = 0; i < 20000; i += 7)
+        m.erase(0, i);  // the value of layer 1, if any, is visible again
+
+    for (int i = 7; i < 20000; i += 7)
+    {
+        if (i % 5 == 0)
+            expected.erase(i);
+        else
+            expected[i] = { i, 1 };
+    }
+    expected.erase(0);
+
+    EXPECT_EQ(m.size(), expected.size());
+    for (int i = 0; i < 20000; ++i)
+    {
+        const auto it = expected.find(i);
+        if (it == expected.end())
+        {
+            EXPECT_EQ(m.get(i), std::nullopt);
+            EXPECT_EQ(m.layer_of(i), value_or_npos);
+        }
+        else
+        {
+            EXPECT_EQ(m.get(i), it->second.first);
+            EXPECT_EQ(m.layer_of(i), it->second.second);
+        }
+    }
+}
+
+TEST(Testlayered_map, LayerOutOfRange)
+{
+    layered_map<int, int> m{ 2 };
+    EXPECT_THROW(m.set(2, 1, 1), std::out_of_range);
+    EXPECT_THROW(m.erase(5, 1), std::out_of_range);
+    const std::vector<std::pair<int, std::optional<int>>> changes{ {1, 1} };
+    EXPECT_THROW(m.update(2, changes), std::out_of_range);
+    EXPECT_EQ(m.get(1), std::nullopt);
+    EXPECT_EQ(m.size(), 0u);
+}
+
+TEST(Testlayered_map, NestedGuards)
+{
+    layered_map<int, int> m{ 1 };
+    m.set(0, 1, 1);
+
+    layered_map_impl::read_guard outer;
+    const auto& reader = layered_map_impl::epoch_domain::local_reader();
+    EXPECT_EQ(m.get(1), 1);     // nested guard
+    ASSERT_NE(reader.s, nullptr);
+    EXPECT_NE(reader.s->epoch.load(), 0u);
+    EXPECT_EQ(reader.depth, 1u);
+}
+
+TEST(Testlayered_map, MoreReadersThanSlots)
+{
+    layered_map<int, int> m{ 1 };
+    m.set(0, 1, 1);
+
+    // all the readers hold a guard at the same time: the ones without a slot do not wait
+    constexpr std::size_t readers_count = layered_map_impl::epoch_domain::max_readers + 8;
+    std::atomic<std::size_t> holding{ 0 };
+    std::atomic<bool> release{ false };
+    std::atomic<bool> error{ false };
+    std::vector<std::thread> readers;
+    for (std::size_t t = 0; t < readers_count; ++t)
+    {
+        readers.emplace_back([&]()
+        {
+            layered_map_impl::read_guard guard;
+            ++holding;
+            while (!release.load())
+            {
+                if (m.get(1) != 1)
+                    error.store(true);
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (holding.load() < readers_count)
+        std::this_thread::yield();
+
+    m.set(0, 2, 2);
+    release.store(true);
+    for (auto& t : readers)
+        t.join();
+    EXPECT_FALSE(error.load());
+    EXPECT_EQ(m.get(2), 2);
+}
@@ -0,0 +1,168 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_lookup.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+struct string_hash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view s) const noexcept
+    {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+using string_map = std::unordered_map<std::string, int, string_hash, std::equal_to<>>;
+
+
+// all the keys in a few buckets, the buckets are walked
+struct collide_hash
+{
+    std::size_t operator()(int k) const noexcept
+    {
+        return static_cast<std::size_t>(k % 3);
+    }
+};
+
+// a map with buckets whose bucket of a key is not hash % bucket_count()
+class reversed_buckets_map
+{
+public:
+    using map_type = std::unordered_map<int, int>;
+    using mapped_type = int;
+    using const_local_iterator = map_type::const_local_iterator;
+    using const_iterator = map_type::const_iterator;
+
+    explicit reversed_buckets_map(map_type m)
+        : _map{ std::move(m) }
+    {}
+
+    std::size_t bucket_count() const { return _map.bucket_count(); }
+    std::size_t bucket(int k) const { return reversed(_map.bucket(k)); }
+    const_local_iterator begin(std::size_t b) const { return _map.begin(reversed(b)); }
+    const_local_iterator end(std::size_t b) const { return _map.end(reversed(b)); }
+    const_iterator find(int k) const { return _map.find(k); }
+    const_iterator end() const { return _map.end(); }
+    map_type::key_equal key_eq() const { return _map.key_eq(); }
+
+private:
+    std::size_t reversed(std::size_t b) const { return _map.bucket_count() - 1 - b; }
+
+    map_type _map;
+};
+
+static_assert(lookup_impl::bucketed<string_map, std::string>);
+static_assert(lookup_impl::bucketed<reversed_buckets_map, int>);
+static_assert(!lookup_impl::bucketed<std::map<int, int>, int>);
+
+TEST(Testlookup_first, Priority)
+{
+    string_map session{ {"a", 1} };
+    string_map tenant{ {"a", 10}, {"b", 20} };
+    std::map<std::string, int, std::less<>> global{ {"a", 100}, {"b", 200}, {"c", 300} };
+
+    const std::vector<std::string_view> keys{ "a", "b", "c", "d" };
+    std::vector<const int*> out(keys.size());
+    EXPECT_EQ(lookup_first(std::span(keys), std::span(out), session, tenant, global), 3u);
+
+    EXPECT_EQ(value_or(0, out[0]), 1);
+    EXPECT_EQ(value_or(0, out[1]), 20);
+    EXPECT_EQ(value_or(0, out[2]), 300);
+    EXPECT_EQ(out[3], nullptr);
+    EXPECT_EQ(value_or(0, out[3]), 0);
+}
+
+TEST(Testlookup_first, ManyKeys)
+{
+    string_map m0;
+    string_map m1;
+    string_map m2;
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i)
+    {
+        names.push_back("key" + std::to_string(i));
+        if (i % 5 == 0) m0.emplace(names.back(), i);
+        if (i % 3 == 0) m1.emplace(names.back(), i * 10);
+        if (i % 2 == 0) m2.emplace(names.back(), i * 100);
+    }
+    const std::vector<std::string_view> keys(names.begin(), names.end());
+
+    std::vector<const int*> out(keys.size());
+    const std::size_t found = lookup_first(keys, std::span(out), m0, m1, m2);
+
+    std::size_t expected_found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        const auto f = [&keys, i](const string_map& m) {
+            const auto it = m.find(keys[i]);
+            return it == m.end() ? nullptr : &it->second;
+        };
+        const int* expected = nullptr;
+        if (const int* p = f(m0)) expected = p;
+        else if (const int* p1 = f(m1)) expected = p1;
+        else if (const int* p2 = f(m2)) expected = p2;
+
+        EXPECT_EQ(out[i], expected);
+        expected_found += expected != nullptr;
+    }
+    EXPECT_EQ(found, expected_found);
+}
+
+TEST(Testlookup_first, Collisions)
+{
+    std::unordered_map<int, int, collide_hash> m0;
+    std::unordered_map<int, int> m1;
+    for (int i = 0; i < 200; ++i)
+    {
+        if (i % 4 == 0) m0.emplace(i, i);
+        if (i % 3 == 0) m1.emplace(i, i * 10);
+    }
+    std::vector<int> keys;
+    for (int i = 0; i < 250; ++i)
+        keys.push_back(i);
+
+    std::vector<const int*> out(keys.size());
+    const std::size_t found = lookup_first(keys, std::span(out), m0, m1);
+
+    std::size_t expected_found = 0;
+    for (int k : keys)
+    {
+        const int* expected = m0.contains(k) ? &m0.at(k) : m1.contains(k) ? &m1.at(k) : nullptr;
+        EXPECT_EQ(out[static_cast<std::size_t>(k)], expected);
+        expected_found += expected != nullptr;
+    }
+    EXPECT_EQ(found, expected_found);
+
+    // empty maps
+    const std::unordered_map<int, int> empty;
+    EXPECT_EQ(lookup_first(keys, std::span(out), empty), 0u);
+    EXPECT_EQ(out[0], nullptr);
+}
+
+TEST(Testlookup_first, MapBucketMapping)
+{
+    std::unordered_map<int, int> m;
+    for (int i = 0; i < 100; i += 2)
+        m.emplace(i, i * 10);
+    const reversed_buckets_map reversed{ m };
+
+    std::vector<int> keys;
+    for (int i = 0; i < 100; ++i)
+        keys.push_back(i);
+    std::vector<const int*> out(keys.size());
+    EXPECT_EQ(lookup_first(keys, std::span(out), reversed), 50u);
+    for (int k : keys)
+        EXPECT_EQ(value_or(-1, out[static_cast<std::size_t>(k)]), k % 2 == 0 ? k * 10 : -1);
+}
@@ -0,0 +1,116 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_pmr.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+// the values converted to V would be temporaries
+static_assert(pmr_impl::column<std::vector<std::optional<std::string>>, std::string>);
+static_assert(pmr_impl::column<std::vector<const std::string*>, std::string>);
+static_assert(!pmr_impl::column<std::vector<std::optional<const char*>>, std::string>);
+static_assert(!pmr_impl::column<std::vector<std::optional<int>>, long>);
+
+
+// the strings are longer than the small string buffer, so every copy allocates
+std::vector<std::optional<std::string>> string_column(std::size_t rows, std::size_t every)
+{
+    std::vector<std::optional<std::string>> r(rows);
+    for (std::size_t i = 0; i < rows; i += every)
+        r[i] = "a string longer than the small string buffer " + std::to_string(i);
+    return r;
+}
+
+
+TEST(Testvalue_or_pmr, Materialize)
+{
+    const auto c0 = string_column(100, 3);
+    const auto c1 = string_column(100, 2);
+    const std::string default_value = "the default value, longer than the small string buffer";
+
+    // every allocation must come from the buffer: the upstream resource throws
+    std::vector<std::byte> buffer(64 * 1024);
+    std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size(), std::pmr::null_memory_resource() };
+    const std::pmr::vector<std::pmr::string> out = value_or_materialize<std::pmr::string>(default_value, &arena, c0, c1);
+
+    ASSERT_EQ(out.size(), c0.size());
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        EXPECT_EQ(std::string_view{ out[i] }, value_or(default_value, c0[i], c1[i]));
+        EXPECT_EQ(out[i].get_allocator().resource(), &arena);
+    }
+}
+
+TEST(Testvalue_or_pmr, MaterializeVector)
+{
+    std::vector<std::unique_ptr<std::vector<int>>> c0(10);
+    std::vector<const std::vector<int>*> c1(10);
+    const std::vector<int> v1{ 4, 5, 6 };
+    const std::vector<int> default_value{ 7 };
+    c0[2] = std::make_unique<std::vector<int>>(std::vector<int>{ 1, 2, 3 });
+    c1[2] = &v1;
+    c1[5] = &v1;
+
+    std::byte buffer[4096];
+    std::pmr::monotonic_buffer_resource buffer_arena{ buffer, sizeof(buffer), std::pmr::null_memory_resource() };
+    const auto out = value_or_materialize<std::pmr::vector<int>>(default_value, &buffer_arena, c0, c1);
+
+    ASSERT_EQ(out.size(), 10);
+    EXPECT_EQ(out[2], std::pmr::vector<int>({ 1, 2, 3 }));
+    EXPECT_EQ(out[5], std::pmr::vector<int>({ 4, 5, 6 }));
+    EXPECT_EQ(out[0], std::pmr::vector<int>({ 7 }));
+    EXPECT_EQ(out[9].get_allocator().resource(), &buffer_arena);
+}
+
+TEST(Testvalue_or_pmr, Borrow)
+{
+    const auto c0 = string_column(50, 4);
+    const auto c1 = string_column(50, 3);
+    const std::string default_value = "default";
+
+    const auto refs = value_or_borrow(default_value, std::pmr::get_default_resource(), c0, c1);
+    const auto views = value_or_string_view(default_value, std::pmr::get_default_resource(), c0, c1);
+
+    ASSERT_EQ(refs.size(), c0.size());
+    ASSERT_EQ(views.size(), c0.size());
+    for (std::size_t i = 0; i < refs.size(); ++i)
+    {
+        const std::string& expected = value_or(default_value, c0[i], c1[i]);
+        EXPECT_EQ(&refs[i].get(), &expected);
+        EXPECT_EQ(views[i].data(), expected.data());
+    }
+}
+
+TEST(Testvalue_or_pmr, TransformView)
+{
+    struct record
+    {
+        std::optional<std::string> name;
+    };
+    std::vector<record> records(6);
+    records[1].name = "one";
+    records[4].name = "four";
+    const std::string default_value = "none";
+
+    // a view that returns the value holders by reference is a column
+    const auto by_reference = records | std::views::transform([](const record& r) -> const std::optional<std::string>& { return r.name; });
+    static_assert(pmr_impl::column<decltype(by_reference), std::string>);
+    const auto views = value_or_string_view(default_value, std::pmr::get_default_resource(), by_reference);
+    ASSERT_EQ(views.size(), records.size());
+    EXPECT_EQ(views[0].data(), default_value.data());
+    EXPECT_EQ(views[4].data(), records[4].name->data());
+
+    // a view that returns them by value is not: the rows would refer to temporaries
+    const auto by_value = records | std::views::transform([](const record& r) { return r.name; });
+    static_assert(!pmr_impl::column<decltype(by_value), std::string>);
+}
@@ -0,0 +1,174 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_project.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+namespace
+{
+    template<typename T>
+    struct test_column
+    {
+        std::vector<T> values;
+        std::vector<std::uint8_t> valid;
+
+        test_column(std::size_t rows, unsigned seed, int null_percent)
+        {
+            std::mt19937 gen{ seed };
+            std::uniform_int_distribution<int> dist{ 0, 99 };
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                valid.push_back(dist(gen) >= null_percent);
+                values.push_back(static_cast<T>(dist(gen)));
+            }
+        }
+
+        nullable_column<T> column() const
+        {
+            return { values, valid };
+        }
+
+        std::optional<T> operator[](std::size_t i) const
+        {
+            return valid[i] ? std::optional<T>{ values[i] } : std::nullopt;
+        }
+    };
+
+    template<typename T, typename F>
+    std::optional<T> map(const std::optional<T>& v, F f)
+    {
+        return v ? std::optional<T>{ f(*v) } : std::nullopt;
+    }
+}
+
+
+TEST(TestProject, Affine)
+{
+    for (std::size_t rows : { 0, 1, 100, 512, 513, 2000 })
+    {
+        const test_column<int> grams{ rows, 1, 60 };
+        const test_column<int> kilograms{ rows, 2, 40 };
+        const test_column<int> tared{ rows, 3, 20 };
+
+        std::vector<int> out(rows);
+        value_or_batch_projected(-1, std::span(out), grams.column(),
+            project_column(kilograms.column(), affine<int>{ 1000, 0 }),
+            project_column(tared.column(), affine<int>{ 1, -5 }));
+
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            EXPECT_EQ(out[i], value_or(-1, grams[i], map(kilograms[i], [](int v) { return v * 1000; }),
+                map(tared[i], [](int v) { return v - 5; })));
+        }
+    }
+}
+
+TEST(TestProject, AffineDouble)
+{
+    const test_column<double> c0{ 1000, 4, 50 };
+    const test_column<double> c1{ 1000, 5, 50 };
+
+    std::vector<double> out(1000);
+    value_or_batch_projected(0.5, std::span(out), project_column(c0.column(), affine<double>{ 2.0, 1.0 }),
+        project_column(c1.column(), affine<double>{ 0.5 }));
+
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        EXPECT_EQ(out[i], value_or(0.5, map(c0[i], [](double v) { return v * 2.0 + 1.0; }),
+            map(c1[i], [](double v) { return v * 0.5; })));
+    }
+}
+
+TEST(TestProject, General)
+{
+    const test_column<int> c0{ 1500, 6, 50 };
+    const test_column<int> c1{ 1500, 7, 50 };
+    const test_column<int> c2{ 1500, 8, 50 };
+    const auto square = [](int v) { return v * v; };
+    const auto negate = [](int v) { return -v; };
+
+    std::vector<int> out(1500);
+    value_or_batch_projected(7, std::span(out), project_column(c0.column(), square),
+        c1.column(), project_column(c2.column(), negate));
+
+    for (std::size_t i = 0; i < out.size(); ++i)
+        EXPECT_EQ(out[i], value_or(7, map(c0[i], square), c1[i], map(c2[i], negate)));
+}
+
+TEST(TestProject, OnlyWinnerProjected)
+{
+    // the projection is applied once for each row it has won, never to the losers
+    const std::vector<int> values{ 1, 2, 3, 4 };
+    const std::vector<std::uint8_t> valid0{ 1, 0, 1, 0 };
+    const std::vector<std::uint8_t> valid1{ 1, 1, 0, 0 };
+    int calls = 0;
+    const auto counted = [&calls](int v) { ++calls; return v + 100; };
+
+    std::vector<int> out(4);
+    value_or_batch_projected(0, std::span(out), nullable_column<int>{ values, valid0 },
+        project_column(nullable_column<int>{ values, valid1 }, counted));
+
+    EXPECT_EQ(out, (std::vector<int>{ 1, 102, 3, 0 }));
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(TestProject, IdentityKeepsBits)
+{
+    // the default value and the columns without projection are copied, not computed
+    const double nan = std::bit_cast<double>(std::uint64_t{ 0x7FF8'0000'0000'1234 });
+    const std::vector<double> values{ -0.0, nan, 2.0, 3.0 };
+    const std::vector<std::uint8_t> valid0{ 1, 1, 0, 0 };
+    const std::vector<std::uint8_t> valid1{ 0, 0, 1, 0 };
+
+    std::vector<double> out(4);
+    value_or_batch_projected(-0.0, std::span(out), nullable_column<double>{ values, valid0 },
+        project_column(nullable_column<double>{ values, valid1 }, affine<double>{ 10.0, 1.0 }));
+
+    EXPECT_TRUE(std::signbit(out[0]));
+    EXPECT_EQ(std::bit_cast<std::uint64_t>(out[1]), std::bit_cast<std::uint64_t>(nan));
+    EXPECT_EQ(out[2], 21.0);
+    EXPECT_TRUE(std::signbit(out[3]));
+}
+
+TEST(TestProject, MixedProjections)
+{
+    // each column uses its own path: affine, general and identity in the same call
+    const test_column<int> c0{ 1500, 9, 50 };
+    const test_column<int> c1{ 1500, 10, 50 };
+    const test_column<int> c2{ 1500, 11, 50 };
+    const auto square = [](int v) { return v * v; };
+
+    std::vector<int> out(1500);
+    value_or_batch_projected(-1, std::span(out), project_column(c0.column(), affine<int>{ 1000, 3 }),
+        project_column(c1.column(), square), c2.column());
+
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        EXPECT_EQ(out[i], value_or(-1, map(c0[i], [](int v) { return v * 1000 + 3; }), map(c1[i], square), c2[i]));
+    }
+}
+
+TEST(TestProject, AffineLosersNotComputed)
+{
+    // the rows won by another column do not enter the affine projection, so they cannot overflow
+    const std::vector<int> values{ std::numeric_limits<int>::max(), 1 };
+    const std::vector<std::uint8_t> valid0{ 1, 0 };
+    const std::vector<std::uint8_t> valid1{ 0, 1 };
+
+    std::vector<int> out(2);
+    value_or_batch_projected(0, std::span(out), nullable_column<int>{ values, valid0 },
+        project_column(nullable_column<int>{ values, valid1 }, affine<int>{ 1000, 0 }));
+    EXPECT_EQ(out, (std::vector<int>{ std::numeric_limits<int>::max(), 1000 }));
+}
@@ -0,0 +1,120 @@
+#include "../value_or_ex/value_or_range.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <list>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testvalue_or_range, EmptyRange)
+{
+    std::vector<std::optional<int>> v;
+    EXPECT_EQ(value_or_range(1, v), 1);
+    EXPECT_EQ(value_or_range_index(v), value_or_npos);
+}
+
+TEST(Testvalue_or_range, Optionals)
+{
+    // sizes around the block size to cover the block scan and the tail
+    for (std::size_t n : { 1, 7, 31, 32, 33, 64, 100, 257 })
+    {
+        for (std::size_t pos = 0; pos < n; pos += 5)
+        {
+            std::vector<std::optional<int>> v(n);
+            v[pos] = static_cast<int>(pos) + 100;
+            if (pos + 3 < n)
+                v[pos + 3] = -1;
+
+            EXPECT_EQ(value_or_range_index(v), pos);
+            EXPECT_EQ(value_or_range(10, v), static_cast<int>(pos) + 100);
+        }
+
+        std::vector<std::optional<int>> nulls(n);
+        EXPECT_EQ(value_or_range_index(nulls), value_or_npos);
+        EXPECT_EQ(value_or_range(10, nulls), 10);
+    }
+}
+
+TEST(Testvalue_or_range, Pointers)
+{
+    std::vector<int> values(300);
+    for (std::size_t n : { 1, 15, 32, 33, 95, 300 })
+    {
+        for (std::size_t pos = 0; pos < n; pos += 7)
+        {
+            std::vector<int*> v(n, nullptr);
+            values[pos] = static_cast<int>(pos) * 2;
+            v[pos] = &values[pos];
+
+            EXPECT_EQ(value_or_range_index(std::span<int*>(v)), pos);
+            EXPECT_EQ(value_or_range(-1, std::span<int* const>(v)), static_cast<int>(pos) * 2);
+        }
+    }
+}
+
+TEST(Testvalue_or_range, Reference)
+{
+    int d = 1;
+    int i = 2;
+    std::vector<int*> v{ nullptr, &i };
+    value_or_range(d, v) = 3;
+    EXPECT_EQ(i, 3);
+
+    std::vector<int*> n{ nullptr, nullptr };
+    value_or_range(d, n) = 4;
+    EXPECT_EQ(d, 4);
+}
+
+TEST(Testvalue_or_range, Invocable)
+{
+    int called = 0;
+    auto def = [&called]() { ++called; return 5; };
+
+    std::vector<std::optional<int>> v{ std::nullopt, 6 };
+    EXPECT_EQ(value_or_range(def, v), 6);
+    EXPECT_EQ(called, 0);
+
+    std::vector<std::optional<int>> n{ std::nullopt };
+    EXPECT_EQ(value_or_range(def, n), 5);
+    EXPECT_EQ(called, 1);
+}
+
+TEST(Testvalue_or_range, NotContiguous)
+{
+    std::list<std::unique_ptr<std::string>> l;
+    l.push_back(nullptr);
+    l.push_back(std::make_unique<std::string>("a"));
+    const std::string def = "z";
+    EXPECT_EQ(value_or_range(def, l), "a");
+    EXPECT_EQ(value_or_range_index(l), 1u);
+}
+
+TEST(Testvalue_or_range, InputRange)
+{
+    // a single pass range: the elements read are consumed
+    std::istringstream in{ "0 0 5 7" };
+    auto holders = std::views::istream<int>(in)
+        | std::views::transform([](int v) { return v != 0 ? std::optional<int>{ v } : std::nullopt; });
+    EXPECT_EQ(value_or_range_index(holders), 2u);
+
+    std::istringstream none{ "0 0" };
+    EXPECT_EQ(value_or_range_index(std::views::istream<int>(none)
+        | std::views::transform([](int v) { return v != 0 ? std::optional<int>{ v } : std::nullopt; })), value_or_npos);
+}
+
+TEST(Testvalue_or_range, Constexpr)
+{
+    constexpr int r = []() {
+        std::optional<int> a[] = { std::nullopt, 3 };
+        return value_or_range(1, a);
+    }();
+    EXPECT_EQ(r, 3);
+}
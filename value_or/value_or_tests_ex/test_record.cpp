@@ -0,0 +1,101 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_record.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <string>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+using point = nullable_struct<int, int, int, int>;
+
+struct optional_point
+{
+    std::optional<int> x, y, z, w;
+};
+
+static_assert(sizeof(point) == 20);
+static_assert(sizeof(point) * 3 <= sizeof(optional_point) * 2);
+static_assert(sizeof(nullable_struct<double, double>) == 24 && sizeof(std::optional<double>) * 2 == 32);
+static_assert(std::is_same_v<point::mask_type, std::uint8_t>);
+static_assert(value_or_value_holder<point::field_holder<0>, int>);
+static_assert(point::mask_of<0, 2>() == 0b0101);
+static_assert(point::all_fields == 0b1111);
+
+
+TEST(TestRecord, Fields)
+{
+    point p;
+    EXPECT_EQ(p.mask(), 0);
+    EXPECT_FALSE(p.has<1>());
+
+    p.set<1>(5);
+    p.set<3>(7);
+    EXPECT_TRUE(p.has<1>());
+    EXPECT_EQ(p.value<1>(), 5);
+    EXPECT_TRUE(p.has_all(point::mask_of<1, 3>()));
+    EXPECT_FALSE(p.has_all(point::mask_of<0, 1>()));
+
+    p.reset<1>();
+    EXPECT_FALSE(p.has<1>());
+    EXPECT_EQ(p.value<1>(), 0);
+    EXPECT_EQ(p.mask(), point::mask_of<3>());
+
+    const point full{ 1, 2, 3, 4 };
+    EXPECT_EQ(full.mask(), point::all_fields);
+}
+
+TEST(TestRecord, FieldHolder)
+{
+    nullable_struct<int, std::string> a;
+    nullable_struct<int, std::string> b;
+    b.set<0>(3);
+    b.set<1>(std::string{ "b" });
+
+    EXPECT_EQ(value_or(-1, a.field<0>(), b.field<0>()), 3);
+    EXPECT_EQ(value_or(std::string{ "x" }, a.field<1>()), "x");
+    EXPECT_EQ(value_or(std::string{ "x" }, a.field<1>(), b.field<1>()), "b");
+}
+
+TEST(TestRecord, Coalesce)
+{
+    point a;
+    a.set<0>(10);
+    point b;
+    b.set<0>(20);
+    b.set<2>(22);
+    point c;
+    c.set<1>(31);
+    const point defaults{ -1, -2, -3, -4 };
+
+    const point r = value_or_record(defaults, a, b, c);
+    EXPECT_EQ(r.mask(), point::all_fields);
+    EXPECT_EQ(r.value<0>(), 10);
+    EXPECT_EQ(r.value<1>(), 31);
+    EXPECT_EQ(r.value<2>(), 22);
+    EXPECT_EQ(r.value<3>(), -4);
+
+    EXPECT_EQ(value_or_record(defaults), defaults);
+
+    // a default record with nulls leaves them null
+    const point partial = value_or_record(a, b);
+    EXPECT_EQ(partial.mask(), (point::mask_of<0, 2>()));
+    EXPECT_EQ(partial.value<0>(), 20);
+    EXPECT_EQ(partial.value<2>(), 22);
+}
+
+TEST(TestRecord, Constexpr)
+{
+    constexpr auto r = []()
+    {
+        nullable_struct<int, char> a;
+        a.set<1>('a');
+        return value_or_record(nullable_struct<int, char>{ 1, 'z' }, a);
+    }();
+    static_assert(r.value<0>() == 1 && r.value<1>() == 'a');
+    EXPECT_EQ(r.value<1>(), 'a');
+}
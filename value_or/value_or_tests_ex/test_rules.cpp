@@ -0,0 +1,120 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_rules.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+namespace
+{
+    template<typename T>
+    struct test_column
+    {
+        std::vector<T> values;
+        std::vector<std::uint8_t> valid;
+
+        test_column(std::size_t rows, unsigned seed, int null_percent)
+        {
+            std::mt19937 gen{ seed };
+            std::uniform_int_distribution<int> dist{ 0, 99 };
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                valid.push_back(dist(gen) >= null_percent);
+                values.push_back(static_cast<T>(dist(gen)));
+            }
+        }
+
+        nullable_column<T> column() const
+        {
+            return { values, valid };
+        }
+
+        std::optional<T> operator[](std::size_t i) const
+        {
+            return valid[i] ? std::optional<T>{ values[i] } : std::nullopt;
+        }
+    };
+
+    constexpr std::string_view names[] = { "A", "B", "C", "D" };
+}
+
+
+TEST(TestRules, SameAsValueOr)
+{
+    const auto rule = coalesce_rule<int>::compile("coalesce(A, B * 1000, C if D, 0)", names);
+
+    for (std::size_t rows : { 0, 1, 100, 512, 513, 2000 })
+    {
+        const test_column<int> a{ rows, 1, 70 };
+        const test_column<int> b{ rows, 2, 60 };
+        const test_column<int> c{ rows, 3, 50 };
+        const test_column<int> d{ rows, 4, 50 };
+        const nullable_column<int> columns[] = { a.column(), b.column(), c.column(), d.column() };
+
+        std::vector<int> out(rows);
+        rule.run(-1, out, columns);
+
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            const std::optional<int> b_scaled = b[i] ? std::optional<int>{ *b[i] * 1000 } : std::nullopt;
+            const std::optional<int> c_if_d = d[i] ? c[i] : std::nullopt;
+            EXPECT_EQ(out[i], value_or(0, a[i], b_scaled, c_if_d));
+        }
+    }
+}
+
+TEST(TestRules, Terms)
+{
+    const std::vector<double> values{ 1, 2, 3 };
+    const std::vector<std::uint8_t> none{ 0, 0, 0 };
+    const std::vector<std::uint8_t> some{ 1, 0, 1 };
+    const nullable_column<double> columns[] = { { values, none }, { values, some } };
+    const std::string_view two[] = { "price", "old_price" };
+    std::vector<double> out(3);
+
+    coalesce_rule<double>::compile("price", two).run(-1, out, columns);
+    EXPECT_EQ(out, (std::vector<double>{ -1, -1, -1 }));
+
+    coalesce_rule<double>::compile(" coalesce( price , old_price * 0.5 + 1 - 0.25 ) ", two).run(-1, out, columns);
+    EXPECT_EQ(out, (std::vector<double>{ 1.25, -1, 2.25 }));
+
+    coalesce_rule<double>::compile("coalesce(price, old_price if old_price and price, -7.5)", two).run(-1, out, columns);
+    EXPECT_EQ(out, (std::vector<double>{ -7.5, -7.5, -7.5 }));
+
+    // * binds tighter than + and -
+    coalesce_rule<double>::compile("coalesce(price, old_price + 32 * 1.5)", two).run(-1, out, columns);
+    EXPECT_EQ(out, (std::vector<double>{ 49, -1, 51 }));
+
+    coalesce_rule<double>::compile("coalesce(price, old_price * 2 + 3 * 4 - 2 * 0.5)", two).run(-1, out, columns);
+    EXPECT_EQ(out, (std::vector<double>{ 13, -1, 17 }));
+
+    // the terms after a number are never used
+    const auto rule = coalesce_rule<double>::compile("coalesce(42, price)", two);
+    rule.run(-1, out, columns);
+    EXPECT_EQ(out, (std::vector<double>{ 42, 42, 42 }));
+}
+
+TEST(TestRules, Errors)
+{
+    EXPECT_THROW((void)coalesce_rule<int>::compile("coalesce(A, E)", names), std::invalid_argument);
+    EXPECT_THROW((void)coalesce_rule<int>::compile("coalesce(A, B", names), std::invalid_argument);
+    EXPECT_THROW((void)coalesce_rule<int>::compile("coalesce(A * B)", names), std::invalid_argument);
+    EXPECT_THROW((void)coalesce_rule<int>::compile("A + 2 * B", names), std::invalid_argument);
+    EXPECT_THROW((void)coalesce_rule<int>::compile("A if", names), std::invalid_argument);
+    EXPECT_THROW((void)coalesce_rule<int>::compile("A B", names), std::invalid_argument);
+    EXPECT_THROW((void)coalesce_rule<int>::compile("", names), std::invalid_argument);
+
+    const auto rule = coalesce_rule<int>::compile("D", names);
+    const nullable_column<int> one[1];
+    std::vector<int> out(0);
+    EXPECT_THROW(rule.run(0, out, one), std::invalid_argument);
+}
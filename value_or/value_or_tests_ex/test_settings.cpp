@@ -0,0 +1,87 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_settings.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+TEST(Testvalue_or_settings, Snapshot)
+{
+    const char* envp[] = { "A=1", "B=x=y", "EMPTY=", "NOEQUAL", nullptr };
+    const settings_snapshot env_snapshot = settings_snapshot::from_environment(envp);
+    EXPECT_EQ(env_snapshot.find("A"), "1");
+    EXPECT_EQ(env_snapshot.find("B"), "x=y");
+    EXPECT_EQ(env_snapshot.find("EMPTY"), "");
+    EXPECT_EQ(env_snapshot.find("NOEQUAL"), std::nullopt);
+    EXPECT_EQ(env_snapshot.find("C"), std::nullopt);
+
+    const char* argv[] = { "app", "--port=80", "--host", "example", "--verbose", "--level", "-3", "file", "--port", "81" };
+    const settings_snapshot args = settings_snapshot::from_command_line(10, argv);
+    EXPECT_EQ(args.find("--port"), "81");
+    EXPECT_EQ(args.find("--host"), "example");
+    EXPECT_EQ(args.find("--verbose"), "");
+    EXPECT_EQ(args.find("--level"), "-3");
+    EXPECT_EQ(args.find("file"), std::nullopt);
+    EXPECT_EQ(args.find("app"), std::nullopt);
+}
+
+TEST(Testvalue_or_settings, ValueOr)
+{
+    const char* argv[] = { "app", "--port=80", "--ratio", "0.25", "--verbose", "--bad", "12x" };
+    set_command_line(7, argv);
+#if defined(_WIN32)
+    _putenv_s("S4_TEST_PORT", "90");
+    _putenv_s("S4_TEST_NAME", "env name");
+#else
+    setenv("S4_TEST_PORT", "90", 1);
+    setenv("S4_TEST_NAME", "env name", 1);
+#endif
+    snapshot_environment();
+
+    EXPECT_EQ(value_or(1, arg<int>("--port"), env<int>("S4_TEST_PORT")), 80);
+    EXPECT_EQ(value_or(1, arg<int>("--other"), env<int>("S4_TEST_PORT")), 90);
+    EXPECT_EQ(value_or(1, arg<int>("--other"), env<int>("S4_TEST_OTHER")), 1);
+    EXPECT_EQ(value_or(1, arg<int>("--bad"), env<int>("S4_TEST_PORT")), 90);
+    EXPECT_EQ(value_or(0.5, arg<double>("--ratio")), 0.25);
+    EXPECT_EQ(value_or(false, arg<bool>("--verbose")), true);
+    EXPECT_EQ(value_or(std::string{ "default" }, arg<std::string>("--name"), env<std::string>("S4_TEST_NAME")), "env name");
+    EXPECT_EQ(value_or(std::string_view{ "default" }, env<std::string_view>("S4_TEST_NAME")), "env name");
+}
+
+TEST(Testvalue_or_settings, TemporaryName)
+{
+    const char* argv[] = { "app", "--port=80" };
+    set_command_line(2, argv);
+
+    // the holder copies the name, the string can be destroyed
+    std::string name = "--port";
+    const arg<int> port{ std::string{ name } };
+    name = "--other";
+    EXPECT_EQ(value_or(1, port), 80);
+}
+
+TEST(Testvalue_or_settings, Lazy)
+{
+    const char* argv[] = { "app", "--a=1", "--b=2" };
+    set_command_line(3, argv);
+
+    // b is not tested because a wins, so it is not looked for nor parsed
+    const arg<int> a{ "--a" };
+    const arg<int> b{ "--b" };
+    EXPECT_EQ(value_or(0, a, b), 1);
+    EXPECT_EQ(value_or(0, b), 2);
+
+    // the value is cached: a new command line does not change it
+    const char* argv2[] = { "app", "--a=5" };
+    set_command_line(2, argv2);
+    EXPECT_EQ(value_or(0, a), 1);
+    EXPECT_EQ(value_or(0, arg<int>("--a")), 5);
+}
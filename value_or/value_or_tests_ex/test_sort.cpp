@@ -0,0 +1,105 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_sort.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+namespace
+{
+    struct record
+    {
+        std::optional<std::int64_t> primary_id;
+        std::optional<std::int64_t> legacy_id;
+        std::string name;
+    };
+
+    std::vector<record> make_records(std::size_t rows, unsigned seed)
+    {
+        std::mt19937 gen{ seed };
+        std::uniform_int_distribution<std::int64_t> id{ -500, 500 };
+        std::bernoulli_distribution null{ 0.4 };
+        std::vector<record> r(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            if (!null(gen))
+                r[i].primary_id = id(gen) * 1'000'000'007;
+            if (!null(gen))
+                r[i].legacy_id = id(gen);
+            r[i].name = "r" + std::to_string(i);
+        }
+        return r;
+    }
+
+    template<typename K, typename F>
+    std::vector<std::size_t> expected_permutation(std::size_t rows, F key)
+    {
+        std::vector<std::size_t> r(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+            r[i] = i;
+        std::stable_sort(r.begin(), r.end(), [&](std::size_t a, std::size_t b) { return key(a) < key(b); });
+        return r;
+    }
+}
+
+
+TEST(TestSort, RadixSameAsStableSort)
+{
+    for (std::size_t rows : { 0, 1, 2, 1000, 20000 })
+    {
+        const std::vector<record> records = make_records(rows, static_cast<unsigned>(rows));
+        const auto key = [&](std::size_t i) { return value_or(std::int64_t{ -1 }, records[i].primary_id, records[i].legacy_id); };
+
+        const coalesced_index<std::int64_t> index = value_or_sort_index(records, std::int64_t{ -1 },
+            &record::primary_id, &record::legacy_id);
+
+        EXPECT_EQ(index.rows, (expected_permutation<std::int64_t>(rows, key)));
+        ASSERT_EQ(index.keys.size(), rows);
+        for (std::size_t i = 0; i < rows; ++i)
+            EXPECT_EQ(index.keys[i], key(index.rows[i]));
+    }
+}
+
+TEST(TestSort, ParallelSameAsStableSort)
+{
+    const std::vector<record> records = make_records(50000, 7);
+    const auto key = [&](std::size_t i) { return records[i].legacy_id ? std::to_string(*records[i].legacy_id) : std::string{ "~" }; };
+    const auto getter = [](const record& r)
+    {
+        return r.legacy_id ? std::optional<std::string>{ std::to_string(*r.legacy_id) } : std::nullopt;
+    };
+
+    for (unsigned threads : { 1u, 3u, 4u })
+    {
+        const coalesced_index<std::string> index = value_or_sort_index(sort_options{ threads, 1000 },
+            records, std::string{ "~" }, getter);
+        EXPECT_EQ(index.rows, (expected_permutation<std::string>(records.size(), key)));
+    }
+}
+
+TEST(TestSort, FindAndUnique)
+{
+    const std::vector<record> records{ { 5, 1, "a" }, { std::nullopt, 3, "b" }, { std::nullopt, std::nullopt, "c" },
+        { 3, std::nullopt, "d" }, { std::nullopt, 5, "e" } };
+
+    const auto index = value_or_sort_index(records, std::int64_t{ 0 }, &record::primary_id, &record::legacy_id);
+    EXPECT_EQ(index.keys, (std::vector<std::int64_t>{ 0, 3, 3, 5, 5 }));
+    EXPECT_EQ(index.rows, (std::vector<std::size_t>{ 2, 1, 3, 0, 4 }));
+
+    const std::span<const std::size_t> fives = index.find(5);
+    EXPECT_EQ(std::vector<std::size_t>(fives.begin(), fives.end()), (std::vector<std::size_t>{ 0, 4 }));
+    EXPECT_TRUE(index.find(4).empty());
+    EXPECT_EQ(index.unique_rows(), (std::vector<std::size_t>{ 2, 1, 0 }));
+
+    EXPECT_EQ(value_or_sort_permutation(records, std::int64_t{ 0 }, &record::primary_id, &record::legacy_id), index.rows);
+}
@@ -0,0 +1,124 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_stream.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#pragma warning( pop )
+
+using namespace s4;
+
+
+// move only input range, like std::generator: the rows 0..rows, every
+// null_every rows is null; it throws at the row throw_at
+class pull_stream
+{
+public:
+    struct sentinel {};
+
+    class iterator
+    {
+    public:
+        using value_type = std::optional<int>;
+        using difference_type = std::ptrdiff_t;
+
+        explicit iterator(pull_stream* s) : _s{ s } {}
+        iterator(iterator&&) = default;
+        iterator& operator=(iterator&&) = default;
+
+        std::optional<int> operator*() const
+        {
+            if (_s->_row == _s->_throw_at)
+                throw std::runtime_error("stream error");
+            return _s->_row % _s->_null_every == 0 ? std::nullopt : std::optional<int>{ _s->_row };
+        }
+        iterator& operator++() { ++_s->_row; return *this; }
+        void operator++(int) { ++_s->_row; }
+        bool operator==(sentinel) const { return _s->_row >= _s->_rows; }
+
+    private:
+        pull_stream* _s;
+    };
+
+    pull_stream(int rows, int null_every, int throw_at = -1)
+        : _rows{ rows }, _null_every{ null_every }, _throw_at{ throw_at }
+    {}
+    pull_stream(pull_stream&&) = default;
+    pull_stream& operator=(pull_stream&&) = default;
+
+    iterator begin() { return iterator{ this }; }
+    sentinel end() { return {}; }
+
+private:
+    int _rows;
+    int _null_every;
+    int _throw_at;
+    int _row = 0;
+};
+
+static_assert(std::ranges::input_range<pull_stream>);
+
+
+TEST(Testcoalesce_stream, Chunks)
+{
+    const std::vector<std::optional<int>> v{ std::nullopt, 10, std::nullopt, std::nullopt, 40 };
+    auto stream = coalesce_stream(-1, v, pull_stream{ 100, 2 });
+
+    std::vector<int> all;
+    for (auto chunk = stream.next_chunk(2); !chunk.empty(); chunk = stream.next_chunk(2))
+    {
+        EXPECT_LE(chunk.size(), 2u);
+        all.insert(all.end(), chunk.begin(), chunk.end());
+    }
+    // the shortest stream has 5 rows
+    EXPECT_EQ(all, std::vector<int>({ -1, 10, -1, 3, 40 }));
+}
+
+TEST(Testcoalesce_stream, SameAsValueOr)
+{
+    auto stream = coalesce_stream(0, pull_stream{ 5000, 3 }, pull_stream{ 6000, 2 }, std::views::iota(0) | std::views::transform([](int) { return std::optional<int>{}; }));
+    std::vector<int> all;
+    for (auto chunk = stream.next_chunk(); !chunk.empty(); chunk = stream.next_chunk())
+        all.insert(all.end(), chunk.begin(), chunk.end());
+
+    ASSERT_EQ(all.size(), 5000u);
+    for (int i = 0; i < 5000; ++i)
+    {
+        const std::optional<int> a = i % 3 == 0 ? std::nullopt : std::optional<int>{ i };
+        const std::optional<int> b = i % 2 == 0 ? std::nullopt : std::optional<int>{ i };
+        EXPECT_EQ(all[i], value_or(0, a, b));
+    }
+}
+
+TEST(Testcoalesce_stream, Async)
+{
+    auto stream = coalesce_stream_async({ 100, 2 }, 0, pull_stream{ 10000, 3 }, pull_stream{ 20000, 2 });
+    std::vector<int> all;
+    for (auto chunk = stream->next_chunk(); !chunk.empty(); chunk = stream->next_chunk())
+    {
+        EXPECT_LE(chunk.size(), 100u);
+        all.insert(all.end(), chunk.begin(), chunk.end());
+    }
+    ASSERT_EQ(all.size(), 10000u);
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_EQ(all[i], value_or(0, i % 3 == 0 ? std::nullopt : std::optional<int>{ i }, i % 2 == 0 ? std::nullopt : std::optional<int>{ i }));
+
+    // the consumer stops before the end: the destructor stops the producer
+    auto partial = coalesce_stream_async({ 10, 1 }, 0, pull_stream{ 1000000, 3 });
+    EXPECT_EQ(partial->next_chunk().size(), 10u);
+}
+
+TEST(Testcoalesce_stream, AsyncError)
+{
+    auto stream = coalesce_stream_async({ 10, 2 }, 0, pull_stream{ 100, 3, 55 });
+    std::size_t rows = 0;
+    EXPECT_THROW(
+        for (auto chunk = stream->next_chunk(); !chunk.empty(); chunk = stream->next_chunk())
+            rows += chunk.size(),
+        std::runtime_error);
+    EXPECT_EQ(rows, 50u);
+}
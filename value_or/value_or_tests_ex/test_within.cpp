@@ -0,0 +1,123 @@
+#include "../value_or_ex/value_or.h"
+#include "../value_or_ex/value_or_within.h"
+
+#pragma warning( push )
+#pragma warning( disable : 26495 )
+#include "gtest/gtest.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#pragma warning( pop )
+
+using namespace s4;
+using namespace std::chrono_literals;
+
+
+template<typename... Args>
+concept within_args = requires(Args... to_test_v)
+{
+    value_or_within(value_or_budget::clock::now(), 0, to_test_v...);
+};
+
+static_assert(within_args<const int*, std::optional<int>, std::function<const int*(const value_or_budget&)>>);
+static_assert(!within_args<std::string>);
+static_assert(!within_args<std::function<std::string()>>);
+
+
+TEST(Testvalue_or_within, SameAsValueOr)
+{
+    const auto deadline = value_or_budget::clock::now() + 1h;
+    const int i = 1;
+    const std::optional<int> empty;
+    const auto up = std::make_unique<int>(2);
+
+    EXPECT_EQ(value_or_within(deadline, 0), 0);
+    EXPECT_EQ(value_or_within(deadline, 0, empty, nullptr), 0);
+    EXPECT_EQ(value_or_within(deadline, 0, empty, &i, up), 1);
+    EXPECT_EQ(value_or_within(deadline, 0, empty, up, &i), 2);
+    EXPECT_EQ(value_or_within(deadline, 0, empty, []() { return std::optional<int>{ 3 }; }, &i), 3);
+    EXPECT_EQ(value_or_within(deadline, []() { return 4; }, empty), 4);
+    EXPECT_EQ(value_or_within(deadline, std::string{ "d" }, std::optional<std::string>{ "s" }), "s");
+}
+
+TEST(Testvalue_or_within, Deadline)
+{
+    int calls = 0;
+    auto source = [&](const value_or_budget&) { ++calls; return std::optional<int>{ 1 }; };
+    const std::optional<int> two{ 2 };
+
+    // the invocables are skipped after the deadline, the values are still tested
+    const auto past = value_or_budget::clock::now() - 1s;
+    EXPECT_EQ(value_or_within(past, 0, source), 0);
+    EXPECT_EQ(value_or_within(past, 0, source, two), 2);
+    EXPECT_EQ(calls, 0);
+
+    const auto future = value_or_budget::clock::now() + 1h;
+    EXPECT_EQ(value_or_within(future, 0, source, two), 1);
+    EXPECT_EQ(calls, 1);
+
+    // a source that uses all the budget: the next invocable is skipped
+    auto slow = [](const value_or_budget& budget)
+    {
+        while (!budget.expired()) {}
+        return std::optional<int>{};
+    };
+    EXPECT_EQ(value_or_within(value_or_budget::clock::now() + 5ms, 0, slow, source), 0);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Testvalue_or_within, Cap)
+{
+    const auto deadline = value_or_budget::clock::now() + 1h;
+
+    value_or_budget::clock::duration seen{};
+    auto source = [&](const value_or_budget& budget)
+    {
+        seen = budget.remaining();
+        while (!budget.expired()) {}
+        return std::optional<int>{};
+    };
+
+    const auto start = value_or_budget::clock::now();
+    EXPECT_EQ(value_or_within(deadline, 5, capped(10ms, source), []() { return std::optional<int>{ 6 }; }), 6);
+    EXPECT_LE(seen, 10ms);
+    EXPECT_GE(value_or_budget::clock::now() - start, 10ms);
+    EXPECT_LT(value_or_budget::clock::now() - start, 1h);
+}
+
+TEST(Testvalue_or_within, Stop)
+{
+    std::stop_source stop;
+    int calls = 0;
+    auto source = [&](const value_or_budget& budget)
+    {
+        ++calls;
+        EXPECT_TRUE(budget.stop_token().stop_possible());
+        stop.request_stop();
+        return budget.expired() ? std::optional<int>{} : std::optional<int>{ 1 };
+    };
+
+    const auto deadline = value_or_budget::clock::now() + 1h;
+    EXPECT_EQ(value_or_within(deadline, stop.get_token(), 0, source, source), 0);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Testvalue_or_within, NullInvocables)
+{
+    const auto deadline = value_or_budget::clock::now() + 1h;
+    const int i = 1;
+
+    // skipped like in value_or
+    const std::function<std::optional<int>()> empty;
+    const std::function<std::optional<int>(const value_or_budget&)> empty_budget;
+    std::optional<int>(*null_function)() = nullptr;
+    EXPECT_EQ(value_or(0, empty, null_function, &i), 1);
+    EXPECT_EQ(value_or_within(deadline, 0, empty, null_function, &i), 1);
+    EXPECT_EQ(value_or_within(deadline, 0, empty_budget, null_function), 0);
+
+    const std::function<std::optional<int>()> two = []() { return std::optional<int>{ 2 }; };
+    EXPECT_EQ(value_or_within(deadline, 0, empty, two), 2);
+}